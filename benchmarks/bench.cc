@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -29,19 +31,26 @@
 volatile bool running = true;
 std::vector<bench_worker *> bench_runner::workers;
 std::vector<bench_worker *> bench_runner::cmdlog_redoers;
+std::vector<std::pair<std::string, std::string>> bench_runner::settings;
 
 thread_local ermia::epoch_num coroutine_batch_end_epoch = 0;
 
-void bench_worker::do_workload_function(uint32_t i) {
+void bench_worker::do_workload_function(uint32_t i, uint64_t intended_us) {
   ASSERT(workload.size() && cmdlog_redo_workload.size() == 0);
+  util::timer first_attempt = latency_start(intended_us, util::timer());
+  bool retried = false;
 retry:
-  util::timer t;
+  util::timer t = latency_start(intended_us, util::timer());
   const unsigned long old_seed = r.get_seed();
   const auto ret = workload[i].fn(this);
   if (finish_workload(ret, i, t)) {
     r.set_seed(old_seed);
+    retried = true;
     goto retry;
   }
+  if (retried && !ret.IsAbort()) {
+    retried_latency[i].add(first_attempt.lap());
+  }
 }
 
 void bench_worker::do_cmdlog_redo_workload_function(uint32_t i, void *param) {
@@ -69,14 +78,145 @@ uint32_t bench_worker::fetch_workload() {
   return 0;
 }
 
+bool bench_worker::next_request(bool wait, txn_request &req) {
+  if (!ermia::config::work_stealing) {
+    if (!next_arrival(wait, req.intended_us)) {
+      return false;
+    }
+    req.workload_idx = fetch_workload();
+    request_home_ = home();
+    return true;
+  }
+
+  // Our own backlog goes oldest first too, so it stays FIFO however much of
+  // it gets stolen. Only once it's empty do we look at others'.
+  while (true) {
+    queue_arrivals();
+    if (pending_requests.steal(req)) {
+      break;
+    }
+    if (!pending_requests.empty()) {
+      continue;  // lost a race with a thief, try again
+    }
+    if (steal_request(req)) {
+      ++ntxn_stolen;
+      break;
+    }
+    if (!wait || !running) {
+      return false;
+    }
+    idle_until(next_arrival_due(), kStealPollUs);
+  }
+  queue_delay.add(util::timer::cur_usec() - req.intended_us);
+  r.reseed(req.seed);
+  request_home_ = req.home;
+  return true;
+}
+
+void bench_worker::start_arrivals(uint64_t now) {
+  arrivals.start(ermia::config::arrival_rate / ermia::config::worker_threads,
+                 ermia::config::arrival_poisson, request_rng.next(), now);
+}
+
+// Moves our due arrivals to where idle workers can steal them. If they don't
+// all fit, the rest stay with the arrival process and keep their intended
+// start.
+void bench_worker::queue_arrivals() {
+  uint64_t now = util::timer::cur_usec();
+  if (!arrivals.started()) {
+    start_arrivals(now);
+  }
+  while (arrivals.peek() <= now) {
+    txn_request req{fetch_workload(), request_rng.next(), home(), arrivals.peek()};
+    if (!pending_requests.push(req)) {
+      break;
+    }
+    arrivals.pop();
+  }
+}
+
+bool bench_worker::next_arrival(bool wait, uint64_t &intended_us) {
+  intended_us = 0;
+  if (!ermia::config::arrival_rate) {
+    return true;
+  }
+  uint64_t now = util::timer::cur_usec();
+  if (!arrivals.started()) {
+    start_arrivals(now);
+  }
+  while (arrivals.peek() > now) {
+    if (!wait || !running) {
+      return false;
+    }
+    idle_until(arrivals.peek(), kArrivalMaxSleepUs);
+    now = util::timer::cur_usec();
+  }
+  intended_us = arrivals.pop();
+  queue_delay.add(now - intended_us);
+  return true;
+}
+
+// Sleeps overshoot by about the default timer slack, so stop sleeping that
+// far ahead of time and spin the rest of the way.
+void bench_worker::idle_until(uint64_t due_us, uint64_t max_us) {
+  static const uint64_t kSleepSlackUs = 60;
+  uint64_t now = util::timer::cur_usec();
+  if (due_us > now + kSleepSlackUs) {
+    usleep(std::min(due_us - now - kSleepSlackUs, max_us));
+  } else {
+    NOP_PAUSE;
+  }
+}
+
+bool bench_worker::steal_request(txn_request &req) {
+  if (steal_victims.empty()) {
+    init_steal_victims();
+  }
+  for (auto *victim : steal_victims) {
+    if (victim->pending_requests.steal(req)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Order the other workers by NUMA distance, then by how far their IDs are
+// from ours so that neighbours on the same node don't all pick the same victim.
+void bench_worker::init_steal_victims() {
+  ALWAYS_ASSERT(me);
+  uint32_t nworkers = bench_runner::workers.size();
+  for (auto *w : bench_runner::workers) {
+    if (w != this && w->me) {
+      steal_victims.push_back(w);
+    }
+  }
+  auto id_distance = [&](const bench_worker *w) {
+    return (w->worker_id + nworkers - worker_id) % nworkers;
+  };
+  std::sort(steal_victims.begin(), steal_victims.end(),
+            [&](const bench_worker *a, const bench_worker *b) {
+              int da = numa_distance(me->node, a->me->node);
+              int db = numa_distance(me->node, b->me->node);
+              if (da != db) {
+                return da < db;
+              }
+              return id_distance(a) < id_distance(b);
+            });
+}
+
 bool bench_worker::finish_workload(rc_t ret, uint32_t workload_idx, util::timer t) {
   if (!ret.IsAbort()) {
     ++ntxn_commits;
     std::get<0>(txn_counts[workload_idx])++;
+    uint64_t latency_us = util::timer(t).lap();
+    txn_latency[workload_idx].add(latency_us);
+    if (workload.size()) {
+      class_latency[workload[workload_idx].cls].add(latency_us);
+    }
     if (!ermia::config::is_backup_srv() && ermia::config::group_commit) {
       ermia::logmgr->enqueue_committed_xct(worker_id, t.get_start());
     } else {
-      latency_numer_us += t.lap();
+      latency_numer_us += latency_us;
     }
     backoff_shifts >>= 1;
   } else {
@@ -87,24 +227,31 @@ bool bench_worker::finish_workload(rc_t ret, uint32_t workload_idx, util::timer
     } else {
       std::get<2>(txn_counts[workload_idx])++;
     }
+    auto &reasons = abort_reasons[workload_idx];
     switch (ret._val) {
       case RC_ABORT_SERIAL:
         inc_ntxn_serial_aborts();
+        ++reasons[kAbortSerial];
         break;
       case RC_ABORT_SI_CONFLICT:
         inc_ntxn_si_aborts();
+        ++reasons[kAbortSIConflict];
         break;
       case RC_ABORT_RW_CONFLICT:
         inc_ntxn_rw_aborts();
+        ++reasons[kAbortRWConflict];
         break;
       case RC_ABORT_INTERNAL:
         inc_ntxn_int_aborts();
+        ++reasons[kAbortInternal];
         break;
       case RC_ABORT_PHANTOM:
         inc_ntxn_phantom_aborts();
+        ++reasons[kAbortPhantom];
         break;
       case RC_ABORT_USER:
         inc_ntxn_user_aborts();
+        ++reasons[kAbortUser];
         break;
       default:
         ALWAYS_ASSERT(false);
@@ -128,18 +275,21 @@ bool bench_worker::finish_workload(rc_t ret, uint32_t workload_idx, util::timer
 void bench_worker::MyWork(char *) {
   if (is_worker) {
     workload = get_workload();
-    txn_counts.resize(workload.size());
+    init_txn_stats(workload.size());
     barrier_a->count_down();
     barrier_b->wait_for();
 
     while (running) {
-      uint32_t workload_idx = fetch_workload();
-      do_workload_function(workload_idx);
+      txn_request req;
+      if (!next_request(true, req)) {
+        break;
+      }
+      do_workload_function(req.workload_idx, req.intended_us);
     }
 
   } else {
     cmdlog_redo_workload = get_cmdlog_redo_workload();
-    txn_counts.resize(cmdlog_redo_workload.size());
+    init_txn_stats(cmdlog_redo_workload.size());
     if (ermia::config::replay_policy == ermia::config::kReplayBackground) {
       ermia::CommandLog::cmd_log->BackgroundReplay(worker_id,
         std::bind(&bench_worker::do_cmdlog_redo_workload_function, this, std::placeholders::_1, std::placeholders::_2));
@@ -367,6 +517,7 @@ void bench_runner::start_measurement() {
   }
 
   barrier_a.wait_for();  // wait for all threads to start up
+  ermia::MM::wait_node_memory_populated();
   std::map<std::string, size_t> table_sizes_before;
   if (ermia::config::verbose) {
     for (std::map<std::string, ermia::OrderedIndex *>::iterator it = open_tables.begin();
@@ -378,9 +529,17 @@ void bench_runner::start_measurement() {
     std::cerr << "starting benchmark..." << std::endl;
   }
 
-  // Print some results every second
+  // Print some results every second, and keep them for --results_json
   uint64_t slept = 0;
   uint64_t last_commits = 0, last_aborts = 0;
+  const bool results_json = !ermia::config::results_json.empty();
+  struct second_sample {
+    uint64_t commits, aborts;
+    double depth;
+    uint64_t p50_us, p99_us, max_us;
+    double cpu_util;
+  };
+  std::vector<second_sample> samples;
 
   // Print CPU utilization as well. Code adapted from:
   // https://stackoverflow.com/questions/63166/how-to-determine-cpu-and-memory-consumption-from-inside-a-process
@@ -397,7 +556,7 @@ void bench_runner::start_measurement() {
   fclose(file);
 
   auto get_cpu_util = [&]() {
-    ASSERT(ermia::config::print_cpu_util);
+    ASSERT(ermia::config::print_cpu_util || results_json);
     struct tms timeSample;
     clock_t now;
     double percent;
@@ -424,17 +583,17 @@ void bench_runner::start_measurement() {
     ermia::rep::TruncateFilesInLogDir();
   }
 
-  if (ermia::config::print_cpu_util) {
-    printf("Sec,Commits,Aborts,CPU\n");
-  } else {
-    printf("Sec,Commits,Aborts\n");
-  }
+  printf("Sec,Commits,Aborts%s%s%s\n", ermia::config::coro_workers ? ",Depth" : "",
+         ermia::config::print_latency_percentiles ? ",P50us,P99us,MaxUs" : "",
+         ermia::config::print_cpu_util ? ",CPU" : "");
 
+  const uint64_t log_start = ermia::logmgr ? ermia::logmgr->cur_lsn().offset() : 0;
   util::timer t, t_nosync;
   barrier_b.count_down();  // bombs away!
 
   double total_util = 0;
   double sec_util = 0;
+  latency_histogram last_latency;
   auto gather_stats = [&]() {
     sleep(1);
     uint64_t sec_commits = 0, sec_aborts = 0;
@@ -447,12 +606,45 @@ void bench_runner::start_measurement() {
     last_commits += sec_commits;
     last_aborts += sec_aborts;
 
-    if (ermia::config::print_cpu_util) {
+    second_sample s = {sec_commits, sec_aborts, 0, 0, 0, 0, 0};
+    printf("%lu,%lu,%lu", slept + 1, sec_commits, sec_aborts);
+    if (ermia::config::coro_workers) {
+      // Average number of in-flight coroutines per coroutine worker
+      uint64_t depth = 0;
+      for (size_t i = 0; i < ermia::config::coro_workers; i++) {
+        depth += workers[i]->get_coro_batch_size();
+      }
+      s.depth = double(depth) / ermia::config::coro_workers;
+      printf(",%.1f", s.depth);
+    }
+    if (ermia::config::print_latency_percentiles || results_json) {
+      latency_histogram total;
+      for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+        for (auto &h : workers[i]->get_txn_latency()) {
+          total.merge(h);
+        }
+      }
+      latency_histogram sec = total;
+      sec.subtract(last_latency);
+      last_latency = total;
+      s.p50_us = sec.percentile(50);
+      s.p99_us = sec.percentile(99);
+      s.max_us = sec.max();
+      if (ermia::config::print_latency_percentiles) {
+        printf(",%lu,%lu,%lu", s.p50_us, s.p99_us, s.max_us);
+      }
+    }
+    if (ermia::config::print_cpu_util || results_json) {
       sec_util = get_cpu_util();
       total_util += sec_util;
-      printf("%lu,%lu,%lu,%.2f%%\n", slept + 1, sec_commits, sec_aborts, sec_util);
-    } else {
-      printf("%lu,%lu,%lu\n", slept + 1, sec_commits, sec_aborts);
+      s.cpu_util = sec_util;
+      if (ermia::config::print_cpu_util) {
+        printf(",%.2f%%", sec_util);
+      }
+    }
+    printf("\n");
+    if (results_json) {
+      samples.push_back(s);
     }
     slept++;
   };
@@ -473,6 +665,8 @@ void bench_runner::start_measurement() {
   for (size_t i = 0; i < ermia::config::worker_threads; i++) {
     workers[i]->Join();
   }
+  const uint64_t log_bytes =
+      ermia::logmgr ? ermia::logmgr->cur_lsn().offset() - log_start : 0;
 
   if (ermia::config::num_backups) {
     delete ermia::logmgr;
@@ -502,6 +696,7 @@ void bench_runner::start_measurement() {
   size_t n_rw_aborts = 0;
   size_t n_phantom_aborts = 0;
   size_t n_query_commits = 0;
+  size_t n_stolen = 0;
   uint64_t latency_numer_us = 0;
   for (size_t i = 0; i < ermia::config::worker_threads; i++) {
     n_commits += workers[i]->get_ntxn_commits();
@@ -513,6 +708,7 @@ void bench_runner::start_measurement() {
     n_rw_aborts += workers[i]->get_ntxn_rw_aborts();
     n_phantom_aborts += workers[i]->get_ntxn_phantom_aborts();
     n_query_commits += workers[i]->get_ntxn_query_commits();
+    n_stolen += workers[i]->get_ntxn_stolen();
     if (ermia::config::is_backup_srv() || !ermia::config::group_commit) {
       latency_numer_us += workers[i]->get_latency_numer_us();
     }
@@ -606,6 +802,31 @@ void bench_runner::start_measurement() {
     std::cerr << "agg_abort_rate: " << agg_abort_rate << " aborts/sec" << std::endl;
     std::cerr << "avg_per_core_abort_rate: " << avg_per_core_abort_rate
          << " aborts/sec/core" << std::endl;
+    if (ermia::config::work_stealing) {
+      std::cerr << "stolen_txns: " << n_stolen << std::endl;
+    }
+    if (ermia::config::coro_tx) {
+      ermia::coro::tcalloc::print_stats(std::cerr);
+    }
+    if (ermia::config::oid_numa_partition) {
+      ermia::oid_access_stats::print(std::cerr);
+    }
+    ermia::MM::print_node_memory_stats(std::cerr);
+    ermia::MM::print_free_object_stats(std::cerr);
+    ermia::str_arena::print_stats(std::cerr);
+    uint64_t probe_hits = 0, probe_misses = 0;
+    for (auto *w : workers) {
+      if (w->get_probe_cache()) {
+        probe_hits += w->get_probe_cache()->hits();
+        probe_misses += w->get_probe_cache()->misses();
+      }
+    }
+    if (probe_hits + probe_misses) {
+      std::cerr << "batch_probe_cache: " << probe_hits << " hits, " << probe_misses << " misses" << std::endl;
+    }
+    if (ermia::config::threadpool) {
+      ermia::thread::PrintWaitStats(std::cerr);
+    }
 #ifndef __clang__
     std::cerr << "txn breakdown: " << util::format_list(agg_txn_counts.begin(),
                                                    agg_txn_counts.end()) << std::endl;
@@ -635,6 +856,81 @@ void bench_runner::start_measurement() {
        << n_serial_aborts << " serial_aborts, " << n_rw_aborts << " rw_aborts, "
        << n_phantom_aborts << " phantom_aborts" << std::endl;
 
+  // Per execution mode breakdown when workers run in different modes
+  std::map<std::string, std::pair<uint32_t, uint64_t>> mode_commits;
+  for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+    auto &m = mode_commits[workers[i]->execution_mode()];
+    ++m.first;
+    m.second += workers[i]->get_ntxn_commits();
+  }
+  if (mode_commits.size() > 1) {
+    std::cout << "---------------------------------------\n";
+    for (auto &m : mode_commits) {
+      std::cout << m.first << "\t" << m.second.first << " workers\t"
+                << m.second.second / elapsed_sec << " commits/s\t"
+                << m.second.second / elapsed_sec / m.second.first << " commits/s/worker\n";
+    }
+  }
+
+  // Latency per transaction class, only interesting if the mix has both
+  latency_histogram class_latency[bench_worker::kNumTxnClasses];
+  for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+    for (uint32_t c = 0; c < bench_worker::kNumTxnClasses; ++c) {
+      class_latency[c].merge(workers[i]->get_class_latency(bench_worker::txn_class(c)));
+    }
+  }
+  if (class_latency[bench_worker::kTxnLong].count()) {
+    std::cout << "---------------------------------------\n";
+    for (uint32_t c = 0; c < bench_worker::kNumTxnClasses; ++c) {
+      auto &h = class_latency[c];
+      std::cout << bench_worker::txn_class_name(bench_worker::txn_class(c)) << "\t"
+                << h.count() / elapsed_sec << " commits/s\t"
+                << h.mean() << " us avg\t" << h.percentile(99) << " us p99\n";
+    }
+  }
+
+  // Tail latency per transaction type; retried ones are those committed after
+  // at least one abort, timed from their first attempt (sequential workers only)
+  const auto &types = workers[0]->workload;
+  std::vector<latency_histogram> txn_latency(types.size());
+  std::vector<latency_histogram> retried_latency(types.size());
+  for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+    for (size_t j = 0; j < types.size(); ++j) {
+      txn_latency[j].merge(workers[i]->get_txn_latency()[j]);
+      retried_latency[j].merge(workers[i]->get_retried_latency()[j]);
+    }
+  }
+  auto print_latency = [](const std::string &name, const latency_histogram &h) {
+    std::cout << name << "\t" << h.count() << "\t" << h.percentile(50) << "\t"
+              << h.percentile(90) << "\t" << h.percentile(99) << "\t"
+              << h.percentile(99.9) << "\t" << h.max() << "\n";
+  };
+  std::cout << "---------------------------------------\n";
+  std::cout << "latency (us)\tcount\tp50\tp90\tp99\tp99.9\tmax\n";
+  for (size_t j = 0; j < types.size(); ++j) {
+    print_latency(types[j].name, txn_latency[j]);
+    if (retried_latency[j].count()) {
+      print_latency(types[j].name + " (retried)", retried_latency[j]);
+    }
+  }
+  if (ermia::config::coro_workers && ermia::config::retry_aborted_transactions) {
+    std::cout << "(coroutine workers don't retry aborted transactions; retried "
+              << "latencies above are from sequential workers only)\n";
+  }
+
+  // Open-loop runs: offered vs. started load and how long arrivals waited
+  latency_histogram queue_delay;
+  for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+    queue_delay.merge(workers[i]->get_queue_delay());
+  }
+  if (ermia::config::arrival_rate) {
+    std::cout << "---------------------------------------\n";
+    std::cout << "open loop (" << (ermia::config::arrival_poisson ? "poisson" : "constant")
+              << ")\t" << ermia::config::arrival_rate << " offered txns/s\t"
+              << queue_delay.count() / elapsed_sec << " started txns/s\n";
+    print_latency("queueing delay", queue_delay);
+  }
+
   std::cout << "---------------------------------------\n";
   for (auto &c : agg_txn_counts) {
     std::cout << c.first << "\t" << std::get<0>(c.second) / (double)elapsed_sec
@@ -644,6 +940,215 @@ void bench_runner::start_measurement() {
          << " user aborts/s\n";
   }
   std::cout.flush();
+
+  if (!results_json) {
+    return;
+  }
+  std::ofstream out(ermia::config::results_json);
+  LOG_IF(FATAL, !out) << "Unable to open " << ermia::config::results_json;
+  out.precision(12);
+  json_writer json(out);
+  auto write_latency = [&](const std::string &key, const latency_histogram &h) {
+    json.begin_object(key);
+    json.value("count", h.count());
+    json.value("mean_us", h.mean());
+    json.value("p50_us", h.percentile(50));
+    json.value("p90_us", h.percentile(90));
+    json.value("p99_us", h.percentile(99));
+    json.value("p99.9_us", h.percentile(99.9));
+    json.value("max_us", h.max());
+    json.end_object();
+  };
+
+  json.begin_object();
+  json.begin_object("config");
+  for (auto &s : settings) {
+    json.value(s.first, s.second);
+  }
+  json.end_object();
+
+  json.begin_object("totals");
+  json.value("seconds", elapsed_sec);
+  json.value("commits", n_commits);
+  json.value("query_commits", n_query_commits);
+  json.value("aborts", n_aborts);
+  json.value("system_aborts", n_aborts - n_user_aborts);
+  json.value("user_aborts", n_user_aborts);
+  json.value("internal_aborts", n_int_aborts);
+  json.value("si_aborts", n_si_aborts);
+  json.value("serial_aborts", n_serial_aborts);
+  json.value("rw_aborts", n_rw_aborts);
+  json.value("phantom_aborts", n_phantom_aborts);
+  json.value("commits_per_sec", agg_throughput);
+  json.value("aborts_per_sec", agg_abort_rate);
+  json.value("avg_latency_us", avg_latency_us);
+  json.value("cpu_util", total_util / elapsed_sec);
+  if (ermia::config::work_stealing) {
+    json.value("stolen_txns", n_stolen);
+  }
+  json.end_object();
+
+  json.begin_array("per_second");
+  for (uint32_t i = 0; i < samples.size(); ++i) {
+    auto &s = samples[i];
+    json.begin_object();
+    json.value("sec", i + 1);
+    json.value("commits", s.commits);
+    json.value("aborts", s.aborts);
+    if (ermia::config::coro_workers) {
+      json.value("depth", s.depth);
+    }
+    json.value("p50_us", s.p50_us);
+    json.value("p99_us", s.p99_us);
+    json.value("max_us", s.max_us);
+    json.value("cpu_util", s.cpu_util);
+    json.end_object();
+  }
+  json.end_array();
+
+  std::vector<bench_worker::abort_counts> abort_reasons(types.size(), bench_worker::abort_counts());
+  for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+    for (size_t j = 0; j < types.size(); ++j) {
+      for (uint32_t a = 0; a < bench_worker::kNumAbortReasons; ++a) {
+        abort_reasons[j][a] += workers[i]->get_abort_reasons()[j][a];
+      }
+    }
+  }
+  json.begin_object("txn_types");
+  for (size_t j = 0; j < types.size(); ++j) {
+    auto &c = agg_txn_counts[types[j].name];
+    json.begin_object(types[j].name);
+    json.value("commits", std::get<0>(c));
+    json.value("aborts", std::get<1>(c));
+    json.value("system_aborts", std::get<2>(c));
+    json.value("user_aborts", std::get<3>(c));
+    json.begin_object("abort_reasons");
+    for (uint32_t a = 0; a < bench_worker::kNumAbortReasons; ++a) {
+      json.value(bench_worker::abort_reason_name(bench_worker::abort_reason(a)),
+                 abort_reasons[j][a]);
+    }
+    json.end_object();
+    write_latency("latency", txn_latency[j]);
+    write_latency("retried_latency", retried_latency[j]);
+    json.end_object();
+  }
+  json.end_object();
+
+  if (ermia::config::arrival_rate) {
+    json.begin_object("open_loop");
+    json.value("process", ermia::config::arrival_poisson ? "poisson" : "constant");
+    json.value("offered_txns_per_sec", ermia::config::arrival_rate);
+    json.value("started_txns_per_sec", queue_delay.count() / elapsed_sec);
+    write_latency("queueing_delay", queue_delay);
+    json.end_object();
+  }
+
+  // GC reclamation shows up as versions recycled into the thread free pools
+  json.begin_object("engine");
+  json.value("log_bytes", log_bytes);
+  auto freed = ermia::MM::get_free_object_totals();
+  json.value("recycled_objects", freed.recycled);
+  json.value("recycled_bytes", freed.recycled_bytes);
+  json.value("free_cached_bytes", freed.cached_bytes);
+  json.begin_array("node_memory");
+  for (int i = 0; i < ermia::config::numa_nodes; i++) {
+    auto m = ermia::MM::get_node_memory_stats(i);
+    json.begin_object();
+    json.value("node", i);
+    json.value("used_bytes", m.used);
+    json.value("reserved_bytes", m.reserved);
+    json.value("populated_bytes", m.populated);
+    json.value("pages", ermia::MM::page_kind_name(m.pages));
+    json.end_object();
+  }
+  json.end_array();
+  json.end_object();
+  json.end_object();
+  out << std::endl;
+  LOG_IF(FATAL, !out) << "Failed writing " << ermia::config::results_json;
+}
+
+void json_writer::prefix(const std::string &key) {
+  if (!has_items.empty()) {
+    if (has_items.back()) {
+      os << ",";
+    }
+    has_items.back() = true;
+  }
+  if (!key.empty()) {
+    write_string(key);
+    os << ":";
+  }
+}
+
+void json_writer::write_string(const std::string &s) {
+  os << '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      case '\t':
+        os << "\\t";
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          os << buf;
+        } else {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+}
+
+void json_writer::begin_object(const std::string &key) {
+  prefix(key);
+  os << "{";
+  has_items.push_back(false);
+}
+
+void json_writer::end_object() {
+  has_items.pop_back();
+  os << "}";
+}
+
+void json_writer::begin_array(const std::string &key) {
+  prefix(key);
+  os << "[";
+  has_items.push_back(false);
+}
+
+void json_writer::end_array() {
+  has_items.pop_back();
+  os << "]";
+}
+
+void json_writer::value(const std::string &key, double v) {
+  prefix(key);
+  if (std::isfinite(v)) {
+    os << v;
+  } else {
+    os << "null";
+  }
+}
+
+void json_writer::value(const std::string &key, bool v) {
+  prefix(key);
+  os << (v ? "true" : "false");
+}
+
+void json_writer::value(const std::string &key, const std::string &v) {
+  prefix(key);
+  write_string(v);
 }
 
 template <typename K, typename V>
@@ -671,6 +1176,93 @@ const tx_stat_map bench_worker::get_cmdlog_txn_counts() const {
   return m;
 }
 
+void latency_histogram::merge(const latency_histogram &other) {
+  for (uint32_t i = 0; i < kBuckets; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+void latency_histogram::subtract(const latency_histogram &earlier) {
+  uint64_t top = 0;
+  for (uint32_t i = 0; i < kBuckets; ++i) {
+    counts_[i] -= std::min(counts_[i], earlier.counts_[i]);
+    if (counts_[i]) {
+      top = bucket_upper_bound(i);
+    }
+  }
+  count_ -= std::min(count_, earlier.count_);
+  sum_ -= std::min(sum_, earlier.sum_);
+  max_ = std::min(max_, top);
+}
+
+uint64_t latency_histogram::percentile(double p) const {
+  if (!count_) {
+    return 0;
+  }
+  uint64_t rank = std::ceil(count_ * p / 100.0);
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < kBuckets; ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(bucket_upper_bound(i), max_);
+    }
+  }
+  return max_;
+}
+
+bool coro_batch_tuner::update(uint32_t n) {
+  if (!ermia::config::coro_adaptive_batch) {
+    return false;
+  }
+  window_txns_ += n;
+  if (window_txns_ < kWindowTxns) {
+    return false;
+  }
+
+  unsigned int unused = 0;
+  uint64_t now = __rdtscp(&unused);
+  double cycles_per_txn = double(now - window_start_) / double(window_txns_);
+  window_txns_ = 0;
+  window_start_ = now;
+
+  // Last move didn't pay off, go the other way
+  if (last_cycles_per_txn_ > 0 && cycles_per_txn > last_cycles_per_txn_) {
+    direction_ = -direction_;
+  }
+  last_cycles_per_txn_ = cycles_per_txn;
+
+  int64_t next = int64_t(size_) + direction_;
+  if (next < int64_t(ermia::config::coro_min_batch_size) ||
+      next > int64_t(ermia::config::coro_batch_size)) {
+    // Hit a bound, probe back inwards next time
+    direction_ = -direction_;
+    return false;
+  }
+  ermia::volatile_write(size_, uint32_t(next));
+  return true;
+}
+
+void bench_worker::init_sequential_txns() {
+  sequential_txns.assign(workload.size(), false);
+  std::stringstream ss(ermia::config::coro_sequential_txns);
+  std::string name;
+  while (std::getline(ss, name, ',')) {
+    if (name.empty()) {
+      continue;
+    }
+    uint32_t i = 0;
+    while (i < workload.size() && workload[i].name != name) {
+      ++i;
+    }
+    LOG_IF(FATAL, i == workload.size())
+      << "Unknown transaction type " << name << " in --coro_sequential_txns";
+    sequential_txns[i] = true;
+  }
+}
+
 void bench_worker::PipelineScheduler() {
 #ifdef BATCH_SAME_TRX
   LOG(FATAL) << "Pipeline scheduler doesn't work with batching same-type transactoins";
@@ -687,40 +1279,86 @@ void bench_worker::PipelineScheduler() {
   rc_t *rcs = (rc_t *)numa_alloc_onnode(
     sizeof(rc_t) * ermia::config::coro_batch_size, numa_node_of_cpu(sched_getcpu()));
 
+  uint64_t *intended_us = (uint64_t *)numa_alloc_onnode(
+    sizeof(uint64_t) * ermia::config::coro_batch_size, numa_node_of_cpu(sched_getcpu()));
+
+  // Open-loop runs leave a slot empty until the next arrival is due
+  auto start_slot = [&](uint32_t j) {
+    txn_request req;
+    if (next_request(false, req)) {
+      workload_idxs[j] = req.workload_idx;
+      intended_us[j] = req.intended_us;
+      handles[j] = workload[req.workload_idx].coro_fn(this, j, 0).get_handle();
+      leave_slot(j);
+    }
+  };
+
+  init_sequential_txns();
   barrier_a->count_down();
   barrier_b->wait_for();
   util::timer t;
-
-  for (uint32_t i = 0; i < ermia::config::coro_batch_size; i++) {
-    uint32_t workload_idx = fetch_workload();
-    workload_idxs[i] = workload_idx;
-    handles[i] = workload[workload_idx].coro_fn(this, i, 0).get_handle();
+  batch_tuner.start();
+
+  // Slots [0, active) get refilled once their transaction finishes; slots
+  // [active, nslots) are left over from a larger depth and just drain.
+  uint32_t active = batch_tuner.size();
+  uint32_t nslots = active;
+  uint32_t draining = 0;
+  for (uint32_t i = 0; i < active; i++) {
+    start_slot(i);
   }
 
   uint32_t i = 0;
   coroutine_batch_end_epoch = 0;
   ermia::epoch_num begin_epoch = ermia::MM::epoch_enter();
   while (running) {
-    if (handles[i].done()) {
+    if (!handles[i]) {
+      // Drained slot, or waiting for an arrival
+      if (i < active) {
+        start_slot(i);
+      }
+    } else if (handles[i].done()) {
       rcs[i] = handles[i].promise().get_return_value();
 #ifdef CORO_BATCH_COMMIT
       if (!rcs[i].IsAbort()) {
         rcs[i] = db->Commit(&transactions[i]);
       }
 #endif
-      finish_workload(rcs[i], workload_idxs[i], t);
+      finish_workload(rcs[i], workload_idxs[i], latency_start(intended_us[i], t));
       handles[i].destroy();
+      handles[i] = nullptr;
+
+      if (i >= active) {
+        --draining;
+      }
+      if (batch_tuner.update(1)) {
+        uint32_t size = batch_tuner.size();
+        for (uint32_t j = active; j < size; j++) {
+          if (!handles[j]) {
+            start_slot(j);
+          }
+        }
+        active = size;
+        nslots = std::max(nslots, active);
+        draining = 0;
+        for (uint32_t j = active; j < nslots; j++) {
+          draining += (handles[j] != nullptr);
+        }
+      }
 
-      uint32_t workload_idx = fetch_workload();
-      workload_idxs[i] = workload_idx;
-      handles[i] = workload[workload_idx].coro_fn(this, i, 0).get_handle();
-    } else if (!handles[i].promise().callee_coro || handles[i].promise().callee_coro.done()) {
-      handles[i].resume();
+      if (i < active) {
+        start_slot(i);
+      }
+      if (!draining) {
+        nslots = active;
+      }
     } else {
-      handles[i].promise().callee_coro.resume();
+      resume_txn(handles[i], i, workload_idxs[i]);
     }
 
-    i = (i + 1) & (ermia::config::coro_batch_size - 1);
+    if (++i >= nslots) {
+      i = 0;
+    }
   }
 
   ermia::MM::epoch_exit(coroutine_batch_end_epoch, begin_epoch);
@@ -744,41 +1382,61 @@ void bench_worker::Scheduler() {
   rc_t *rcs = (rc_t *)numa_alloc_onnode(
     sizeof(rc_t) * ermia::config::coro_batch_size, numa_node_of_cpu(sched_getcpu()));
 
+  uint64_t *intended_us = (uint64_t *)numa_alloc_onnode(
+    sizeof(uint64_t) * ermia::config::coro_batch_size, numa_node_of_cpu(sched_getcpu()));
+
+  init_sequential_txns();
   barrier_a->count_down();
   barrier_b->wait_for();
+  batch_tuner.start();
 
   while (running) {
+    // Open-loop runs wait for one arrival, then batch whatever else is due
+    txn_request req;
+    if (!next_request(true, req)) {
+      break;
+    }
     coroutine_batch_end_epoch = 0;
     ermia::epoch_num begin_epoch = ermia::MM::epoch_enter();
-    uint32_t todo = ermia::config::coro_batch_size;
+    const uint32_t max_batch_size = batch_tuner.size();
+    uint32_t batch_size = 0;
     util::timer t;
 
-    for (uint32_t i = 0; i < ermia::config::coro_batch_size; i++) {
-      uint32_t workload_idx = fetch_workload();
-      workload_idxs[i] = workload_idx;
-      handles[i] = workload[workload_idx].coro_fn(this, i, 0).get_handle();
+    do {
+      workload_idxs[batch_size] = req.workload_idx;
+      intended_us[batch_size] = req.intended_us;
+      handles[batch_size] = workload[req.workload_idx].coro_fn(this, batch_size, 0).get_handle();
+      leave_slot(batch_size);
+    } while (++batch_size < max_batch_size && next_request(false, req));
+    uint32_t todo = batch_size;
+
+    uint32_t short_todo = 0;
+    for (uint32_t i = 0; i < batch_size; i++) {
+      short_todo += (workload[workload_idxs[i]].cls == kTxnShort);
     }
 
-    while (todo) {
-      for (uint32_t i = 0; i < ermia::config::coro_batch_size; i++) {
+    for (uint32_t round = 0; todo; ++round) {
+      for (uint32_t i = 0; i < batch_size; i++) {
         if (!handles[i]) {
           continue;
         }
         if (handles[i].done()) {
           rcs[i] = handles[i].promise().get_return_value();
-          finish_workload(rcs[i], workload_idxs[i], t);
+          finish_workload(rcs[i], workload_idxs[i], latency_start(intended_us[i], t));
           handles[i].destroy();
           handles[i] = nullptr;
           --todo;
-        } else if (!handles[i].promise().callee_coro || handles[i].promise().callee_coro.done()) {
-          handles[i].resume();
+          short_todo -= (workload[workload_idxs[i]].cls == kTxnShort);
+        } else if (!should_resume(workload_idxs[i], round, short_todo)) {
+          // Let the short ones go ahead
         } else {
-          handles[i].promise().callee_coro.resume();
+          resume_txn(handles[i], i, workload_idxs[i]);
         }
       }
     }
 
     ermia::MM::epoch_exit(coroutine_batch_end_epoch, begin_epoch);
+    batch_tuner.update(batch_size);
   }
 }
 
@@ -790,58 +1448,74 @@ void bench_worker::BatchScheduler() {
   rc_t *rcs = (rc_t *)numa_alloc_onnode(
     sizeof(rc_t) * ermia::config::coro_batch_size, numa_node_of_cpu(sched_getcpu()));
 
+  uint64_t *intended_us = (uint64_t *)numa_alloc_onnode(
+    sizeof(uint64_t) * ermia::config::coro_batch_size, numa_node_of_cpu(sched_getcpu()));
+
 #ifndef BATCH_SAME_TRX
   LOG(FATAL) << "Batch scheduler batches same-type transactoins";
 #endif
 
+  if (ermia::config::coro_batch_probe_cache) {
+    probe_cache = new ermia::BatchProbeCache();
+    ermia::tls_batch_probe_cache = probe_cache;
+  }
+
+  init_sequential_txns();
   barrier_a->count_down();
   barrier_b->wait_for();
+  batch_tuner.start();
 
   while (running) {
+    // Open-loop runs wait for one arrival, then batch whatever else is due
+    if (!next_arrival(true, intended_us[0])) {
+      break;
+    }
+    if (probe_cache) {
+      probe_cache->Clear();
+    }
     coroutine_batch_end_epoch = 0;
     ermia::epoch_num begin_epoch = ermia::MM::epoch_enter();
-    uint32_t todo = ermia::config::coro_batch_size;
+    const uint32_t max_batch_size = batch_tuner.size();
+    uint32_t batch_size = 0;
     uint32_t workload_idx = -1;
     workload_idx = fetch_workload();
     util::timer t;
 
-    for (uint32_t i = 0; i < ermia::config::coro_batch_size; i++) {
-      handles[i] = workload[workload_idx].coro_fn(this, i, 0).get_handle();
-    }
+    do {
+      handles[batch_size] = workload[workload_idx].coro_fn(this, batch_size, 0).get_handle();
+    } while (++batch_size < max_batch_size && next_arrival(false, intended_us[batch_size]));
+    uint32_t todo = batch_size;
 
     while (todo) {
-      for (uint32_t i = 0; i < ermia::config::coro_batch_size; i++) {
+      for (uint32_t i = 0; i < batch_size; i++) {
         if (!handles[i]) {
           continue;
         }
         if (handles[i].done()) {
           rcs[i] = handles[i].promise().get_return_value();
 #ifndef CORO_BATCH_COMMIT
-          finish_workload(rcs[i], workload_idx, t);
+          finish_workload(rcs[i], workload_idx, latency_start(intended_us[i], t));
 #endif
           handles[i].destroy();
           handles[i] = nullptr;
           --todo;
-        } else if (!handles[i].promise().callee_coro || handles[i].promise().callee_coro.done()) {
-          handles[i].resume();
         } else {
-          handles[i].promise().callee_coro.resume();
+          resume_txn(handles[i], i, workload_idx);
         }
       }
     }
 
 #ifdef CORO_BATCH_COMMIT
-    for (uint32_t i = 0; i < ermia::config::coro_batch_size; i++) {
+    for (uint32_t i = 0; i < batch_size; i++) {
       if (!rcs[i].IsAbort()) {
         rcs[i] = db->Commit(&transactions[i]);
       }
       // No need to abort - TryCatchCond family of macros should have already
-      finish_workload(rcs[i], workload_idx, t);
+      finish_workload(rcs[i], workload_idx, latency_start(intended_us[i], t));
     }
 #endif
 
     ermia::MM::epoch_exit(coroutine_batch_end_epoch, begin_epoch);
+    batch_tuner.update(batch_size);
   }
 }
-
-
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <ostream>
 #include <set>
 #include <vector>
 #include <utility>
@@ -15,6 +19,7 @@ extern void ycsb_cs_do_test(ermia::Engine *db, int argc, char **argv);
 extern void ycsb_cs_advance_do_test(ermia::Engine *db, int argc, char **argv);
 extern void tpcc_do_test(ermia::Engine *db, int argc, char **argv);
 extern void tpcc_cs_do_test(ermia::Engine *db, int argc, char **argv);
+extern void tpcc_dora_do_test(ermia::Engine *db, int argc, char **argv);
 extern void tpce_do_test(ermia::Engine *db, int argc, char **argv);
 
 enum { RUNMODE_TIME = 0, RUNMODE_OPS = 1 };
@@ -63,9 +68,231 @@ class bench_loader : public ermia::thread::Runner {
   ermia::str_arena *arena;
 };
 
+// Picks the number of in-flight coroutines (active slots) for a worker.
+// With --coro_adaptive_batch it hill-climbs on rdtsc cycles per finished
+// transaction: every kWindowTxns transactions it moves the depth by one
+// slot, and turns around whenever the last move made things slower. The
+// depth stays within [coro_min_batch_size, coro_batch_size]; slot memory
+// is always preallocated for coro_batch_size.
+class coro_batch_tuner {
+ public:
+  static const uint32_t kWindowTxns = 4096;
+
+  coro_batch_tuner()
+      : size_(ermia::config::coro_batch_size),
+        direction_(1),
+        window_txns_(0),
+        window_start_(0),
+        last_cycles_per_txn_(0) {
+    if (ermia::config::coro_adaptive_batch) {
+      size_ = (ermia::config::coro_min_batch_size + ermia::config::coro_batch_size) / 2;
+    }
+  }
+
+  inline uint32_t size() const { return ermia::volatile_read(size_); }
+
+  // Start the first measurement window, call once the benchmark starts.
+  inline void start() {
+    unsigned int unused = 0;
+    window_start_ = __rdtscp(&unused);
+  }
+
+  // Account for [n] finished transactions. Returns true if the depth changed.
+  bool update(uint32_t n);
+
+ private:
+  uint32_t size_;
+  int32_t direction_;
+  uint32_t window_txns_;
+  uint64_t window_start_;
+  double last_cycles_per_txn_;
+};
+
+// Intended start times of one worker's transactions under --arrival_rate:
+// evenly spaced or with exponential gaps (Poisson arrivals), counted from the
+// first call. The times don't depend on when transactions actually finish,
+// so arrivals that are due but not taken yet are the worker's queue.
+class arrival_process {
+ public:
+  arrival_process() : rng_(0), mean_gap_us_(0), next_us_(0) {}
+
+  inline bool started() const { return next_us_ != 0; }
+
+  inline void start(double rate_per_sec, bool poisson, unsigned long seed, uint64_t now_us) {
+    ALWAYS_ASSERT(rate_per_sec > 0);
+    rng_ = util::fast_random(seed);
+    poisson_ = poisson;
+    mean_gap_us_ = 1000000.0 / rate_per_sec;
+    next_us_ = now_us + gap();
+  }
+
+  // Intended start of the oldest arrival not taken yet
+  inline uint64_t peek() const { return (uint64_t)next_us_; }
+
+  inline uint64_t pop() {
+    uint64_t t = peek();
+    next_us_ += gap();
+    return t;
+  }
+
+ private:
+  inline double gap() {
+    return poisson_ ? -std::log(1.0 - rng_.next_uniform()) * mean_gap_us_ : mean_gap_us_;
+  }
+
+  util::fast_random rng_;
+  bool poisson_;
+  double mean_gap_us_;
+  double next_us_;
+};
+
+// A not-yet-started transaction with everything that decides its inputs, so
+// that whoever runs it runs the same transaction: the runner's RNG gets
+// reseeded with [seed], and [home] is the issuing worker's home() (e.g., its
+// TPC-C home warehouse).
+struct txn_request {
+  uint32_t workload_idx;
+  unsigned long seed;
+  uint32_t home;
+  uint64_t intended_us;  // open-loop intended start
+};
+
+// Fixed-capacity queue of due open-loop arrivals for --work_stealing: the
+// owning worker pushes at the bottom, and everyone, the owner included, takes
+// the oldest from the top, all without locks (Chase-Lev without the owner's
+// LIFO end, so that queueing delay stays first come, first served).
+class txn_request_queue {
+ public:
+  static const int64_t kCapacity = 256;  // must be a power of two
+
+  txn_request_queue() : top_(0), bottom_(0) {}
+
+  // Owner only
+  inline bool push(const txn_request &req) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= kCapacity) {
+      return false;
+    }
+    slots_[b & (kCapacity - 1)] = req;
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  inline bool empty() const {
+    return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+  }
+
+  // Any thread, oldest first; can fail on a race while not empty
+  inline bool steal(txn_request &out) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    out = slots_[t & (kCapacity - 1)];
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> top_ CACHE_ALIGNED;
+  std::atomic<int64_t> bottom_ CACHE_ALIGNED;
+  txn_request slots_[kCapacity] CACHE_ALIGNED;
+};
+
+// Log-linear histogram of latencies in microseconds: exact below 16us, then
+// 16 buckets per power of two, i.e., within 1/16 of the real value. Each
+// worker owns (and is the only writer of) its histograms; the runner may read
+// them concurrently for per-second reports, which then can be off by the few
+// transactions in flight, but never block the worker.
+class latency_histogram {
+ public:
+  static const uint32_t kSubBuckets = 16;
+  static const uint32_t kSubBucketBits = 4;
+  static const uint32_t kBuckets = kSubBuckets * (64 - kSubBucketBits + 1);
+
+  latency_histogram() { memset(this, 0, sizeof(*this)); }
+
+  inline void add(uint64_t us) {
+    ++counts_[bucket_of(us)];
+    ++count_;
+    sum_ += us;
+    if (us > max_) {
+      max_ = us;
+    }
+  }
+
+  void merge(const latency_histogram &other);
+
+  // Remove an earlier snapshot of the same histogram, leaving what was
+  // recorded since. The max becomes the bound of the highest bucket left.
+  void subtract(const latency_histogram &earlier);
+
+  // Upper bound of the bucket holding the [p]-th percentile, p in (0, 100]
+  uint64_t percentile(double p) const;
+
+  inline uint64_t count() const { return count_; }
+  inline uint64_t max() const { return max_; }
+  inline double mean() const { return count_ ? double(sum_) / count_ : 0; }
+
+ private:
+  static inline uint32_t bucket_of(uint64_t us) {
+    if (us < kSubBuckets) {
+      return us;
+    }
+    uint32_t exp = 63 - __builtin_clzll(us);
+    uint32_t sub = (us >> (exp - kSubBucketBits)) & (kSubBuckets - 1);
+    return kSubBuckets + (exp - kSubBucketBits) * kSubBuckets + sub;
+  }
+
+  static inline uint64_t bucket_upper_bound(uint32_t b) {
+    if (b < kSubBuckets) {
+      return b;
+    }
+    uint32_t exp = (b - kSubBuckets) / kSubBuckets;
+    uint64_t sub = (b - kSubBuckets) % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << exp) - 1;
+  }
+
+  uint64_t counts_[kBuckets];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+};
+
 typedef std::tuple<uint64_t, uint64_t, uint64_t, uint64_t> tx_stat;
 typedef std::map<std::string, tx_stat> tx_stat_map;
 
+// Streams JSON for --results_json; keeps track of nesting so that commas
+// come out right. Empty keys are for array elements.
+class json_writer {
+ public:
+  json_writer(std::ostream &os) : os(os) {}
+  void begin_object(const std::string &key = "");
+  void end_object();
+  void begin_array(const std::string &key = "");
+  void end_array();
+  template <typename T>
+  void value(const std::string &key, T v) {
+    prefix(key);
+    os << v;
+  }
+  void value(const std::string &key, double v);  // null if not finite
+  void value(const std::string &key, bool v);
+  void value(const std::string &key, const std::string &v);
+  void value(const std::string &key, const char *v) { value(key, std::string(v)); }
+
+ private:
+  void prefix(const std::string &key);
+  void write_string(const std::string &s);
+
+  std::ostream &os;
+  std::vector<bool> has_items;  // per open object/array
+};
+
 class bench_worker : public ermia::thread::Runner {
   friend class ermia::sm_log_alloc_mgr;
 
@@ -77,6 +304,7 @@ class bench_worker : public ermia::thread::Runner {
         worker_id(worker_id),
         is_worker(is_worker),
         r(seed),
+        request_rng(~seed),
         db(db),
         open_tables(open_tables),
         barrier_a(barrier_a),
@@ -93,9 +321,15 @@ class bench_worker : public ermia::thread::Runner {
         ntxn_serial_aborts(0),
         ntxn_rw_aborts(0),
         ntxn_phantom_aborts(0),
-        ntxn_query_commits(0) {
+        ntxn_query_commits(0),
+        ntxn_stolen(0),
+        request_home_(0),
+        probe_cache(nullptr) {
     txn_obj_buf = (ermia::transaction *)malloc(sizeof(ermia::transaction));
     arena = new ermia::str_arena(ermia::config::arena_size_mb);
+    if (ermia::config::work_stealing && ermia::config::coro_tx) {
+      slot_rng.resize(ermia::config::coro_batch_size);
+    }
     if (ermia::config::numa_spread) {
       LOG(INFO) << "Worker " << worker_id << " going to node " << worker_id % ermia::config::numa_nodes;
       TryImpersonate(worker_id % ermia::config::numa_nodes);
@@ -134,19 +368,50 @@ class bench_worker : public ermia::thread::Runner {
   typedef std::experimental::coroutine_handle<ermia::coro::generator<rc_t>::promise_type> CoroTxnHandle;
   typedef ermia::coro::generator<rc_t> (*coro_txn_fn_t)(bench_worker *, uint32_t, ermia::epoch_num);
   typedef ermia::coro::task<rc_t> (*task_fn_t)(bench_worker *, uint32_t, ermia::epoch_num);
+
+  // Coroutine schedulers favor short transactions over long ones (scans,
+  // analytical queries) that share a batch with them, see
+  // --coro_long_txn_interval.
+  enum txn_class { kTxnShort, kTxnLong, kNumTxnClasses };
+  static const char *txn_class_name(txn_class c) {
+    return c == kTxnShort ? "short" : "long";
+  }
+
+  // Why transactions aborted, counted per workload type
+  enum abort_reason {
+    kAbortSerial,
+    kAbortSIConflict,
+    kAbortRWConflict,
+    kAbortInternal,
+    kAbortPhantom,
+    kAbortUser,
+    kNumAbortReasons
+  };
+  static const char *abort_reason_name(abort_reason a) {
+    static const char *names[] = {"serial", "si_conflict", "rw_conflict",
+                                  "internal", "phantom", "user"};
+    return names[a];
+  }
+  typedef std::array<size_t, kNumAbortReasons> abort_counts;
+
   struct workload_desc {
-    workload_desc() {}
+    workload_desc() : cls(kTxnShort) {}
     workload_desc(const std::string &name, double frequency, txn_fn_t fn,
                   coro_txn_fn_t cf=nullptr, task_fn_t tf=nullptr)
-        : name(name), frequency(frequency), fn(fn), coro_fn(cf) , task_fn(tf) {
+        : name(name), frequency(frequency), fn(fn), coro_fn(cf) , task_fn(tf), cls(kTxnShort) {
       ALWAYS_ASSERT(frequency > 0.0);
       ALWAYS_ASSERT(frequency <= 1.0);
     }
+    workload_desc &long_running() {
+      cls = kTxnLong;
+      return *this;
+    }
     std::string name;
     double frequency;
     txn_fn_t fn;
     coro_txn_fn_t coro_fn;
     task_fn_t task_fn;
+    txn_class cls;
   };
   typedef std::vector<workload_desc> workload_desc_vec;
   virtual workload_desc_vec get_workload() const = 0;
@@ -162,6 +427,8 @@ class bench_worker : public ermia::thread::Runner {
   inline size_t get_ntxn_int_aborts() const { return ntxn_int_aborts; }
   inline size_t get_ntxn_phantom_aborts() const { return ntxn_phantom_aborts; }
   inline size_t get_ntxn_query_commits() const { return ntxn_query_commits; }
+  inline size_t get_ntxn_stolen() const { return ntxn_stolen; }
+  inline const ermia::BatchProbeCache *get_probe_cache() const { return probe_cache; }
   inline void inc_ntxn_user_aborts() { ++ntxn_user_aborts; }
   inline void inc_ntxn_si_aborts() { ++ntxn_si_aborts; }
   inline void inc_ntxn_serial_aborts() { ++ntxn_serial_aborts; }
@@ -178,14 +445,81 @@ class bench_worker : public ermia::thread::Runner {
     return double(latency_numer_us) / double(ntxn_commits);
   }
 
+  inline uint32_t get_coro_batch_size() const { return batch_tuner.size(); }
+
+  // How long open-loop arrivals waited before their transaction started
+  inline const latency_histogram &get_queue_delay() const { return queue_delay; }
+
+  // Committed transaction latencies per class
+  inline const latency_histogram &get_class_latency(txn_class c) const {
+    return class_latency[c];
+  }
+
+  // Committed transaction latencies per workload type, and end-to-end
+  // latencies (from the first attempt) of those committed after retrying.
+  // Only sequential workers retry; the coroutine schedulers drop aborted
+  // transactions, so they never record retried latencies.
+  inline const std::vector<latency_histogram> &get_txn_latency() const {
+    return txn_latency;
+  }
+  inline const std::vector<latency_histogram> &get_retried_latency() const {
+    return retried_latency;
+  }
+  inline const std::vector<abort_counts> &get_abort_reasons() const {
+    return abort_reasons;
+  }
+
+  // Whether the transaction of [workload_idx] gets resumed in scheduling
+  // round [round], given whether any short ones are still in the batch
+  inline bool should_resume(uint32_t workload_idx, uint32_t round, bool short_in_flight) const {
+    return workload[workload_idx].cls == kTxnShort || !short_in_flight ||
+           round % ermia::config::coro_long_txn_interval == 0;
+  }
+
+  // How this worker runs its transactions, for reporting
+  virtual const char *execution_mode() const { return "sequential"; }
+
+  // What transactions issued by this worker are tied to, carried along when
+  // they get stolen; TPC-C's home warehouse
+  virtual uint32_t home() const { return 0; }
+
   const tx_stat_map get_txn_counts() const;
   const tx_stat_map get_cmdlog_txn_counts() const;
 
-  void do_workload_function(uint32_t i);
+  void do_workload_function(uint32_t i, uint64_t intended_us = 0);
   void do_cmdlog_redo_workload_function(uint32_t i, void *param);
   uint32_t fetch_workload();
   bool finish_workload(rc_t ret, uint32_t workload_idx, util::timer t);
 
+  // Takes the next arrival under --arrival_rate, setting [intended_us] to its
+  // intended start; false if none is due yet and [wait] isn't set, or the run
+  // stopped while waiting. Closed-loop runs always get one, with no intended
+  // start.
+  bool next_arrival(bool wait, uint64_t &intended_us);
+
+  // Takes the next transaction to run, like next_arrival() plus picking its
+  // type. With --work_stealing our due arrivals are queued where idle workers
+  // can take them, and once we have none left we take theirs, nearest first.
+  // The RNG and request_home() are then set up for [req].
+  bool next_request(bool wait, txn_request &req);
+
+  // Intended start of our next open-loop arrival, 0 if there's none
+  inline uint64_t next_arrival_due() const {
+    return arrivals.started() ? arrivals.peek() : 0;
+  }
+
+  // Waits for part of the time until [due_us] without holding the core:
+  // sleeps (at most [max_us]) while that can't overshoot it, spins only
+  // for the last few microseconds.
+  static void idle_until(uint64_t due_us, uint64_t max_us);
+
+  // Where a transaction's latency counts from: its intended start in open-loop
+  // runs, so that queueing shows up (no coordinated omission), otherwise when
+  // it (or its batch) got started.
+  static inline util::timer latency_start(uint64_t intended_us, const util::timer &started) {
+    return intended_us ? util::timer(intended_us) : started;
+  }
+
  protected:
   virtual void MyWork(char *);
   inline ermia::transaction *txn_buf() { return txn_obj_buf; }
@@ -193,6 +527,7 @@ class bench_worker : public ermia::thread::Runner {
   unsigned int worker_id;
   bool is_worker;
   util::fast_random r;
+  util::fast_random request_rng;  // seeds for txn_requests
   ermia::Engine *const db;
   std::map<std::string, ermia::OrderedIndex *> open_tables;
   spin_barrier *const barrier_a;
@@ -203,6 +538,25 @@ class bench_worker : public ermia::thread::Runner {
   void PipelineScheduler();
   void BatchScheduler();
 
+  // Whether each workload type runs to completion once started instead of
+  // interleaving with the rest of the batch (--coro_sequential_txns)
+  std::vector<bool> sequential_txns;
+  void init_sequential_txns();
+
+  // Takes the next step of the transaction in [slot], or all of them if its
+  // type is sequential
+  inline void resume_txn(CoroTxnHandle &h, uint32_t slot, uint32_t workload_idx) {
+    enter_slot(slot);
+    do {
+      if (!h.promise().callee_coro || h.promise().callee_coro.done()) {
+        h.resume();
+      } else {
+        h.promise().callee_coro.resume();
+      }
+    } while (sequential_txns[workload_idx] && !h.done());
+    leave_slot(slot);
+  }
+
  private:
   uint64_t latency_numer_us;
   unsigned backoff_shifts;
@@ -217,9 +571,55 @@ class bench_worker : public ermia::thread::Runner {
   size_t ntxn_rw_aborts;
   size_t ntxn_phantom_aborts;
   size_t ntxn_query_commits;
+  size_t ntxn_stolen;
+  latency_histogram class_latency[kNumTxnClasses];
+  arrival_process arrivals;
+  latency_histogram queue_delay;
+  // Bounds each sleep waiting for an arrival, so workers notice the end of
+  // the run
+  static const uint64_t kArrivalMaxSleepUs = 1000;
+
+  // Work stealing: due arrivals and whom to steal from, nearest first
+  txn_request_queue pending_requests;
+  std::vector<bench_worker *> steal_victims;
+  // Longest an idle worker sleeps before looking for work to steal again
+  static const uint64_t kStealPollUs = 20;
+  void init_steal_victims();
+  void start_arrivals(uint64_t now);
+  void queue_arrivals();
+  bool steal_request(txn_request &req);
+  uint32_t request_home_;
 
  protected:
   std::vector<tx_stat> txn_counts;  // commits and aborts breakdown
+  std::vector<latency_histogram> txn_latency;
+  std::vector<latency_histogram> retried_latency;
+  std::vector<abort_counts> abort_reasons;
+
+  // home() of the issuer of the transaction being started, usually ours
+  inline uint32_t request_home() const { return request_home_; }
+
+  // With --work_stealing every in-flight coroutine draws its inputs from its
+  // own request's seed: the scheduler saves r after starting a slot's
+  // transaction and swaps it back in around each resume.
+  std::vector<unsigned long> slot_rng;
+  inline void enter_slot(uint32_t slot) {
+    if (!slot_rng.empty()) {
+      r.set_seed(slot_rng[slot]);
+    }
+  }
+  inline void leave_slot(uint32_t slot) {
+    if (!slot_rng.empty()) {
+      slot_rng[slot] = r.get_seed();
+    }
+  }
+
+  inline void init_txn_stats(size_t ntypes) {
+    txn_counts.resize(ntypes);
+    txn_latency.resize(ntypes);
+    retried_latency.resize(ntypes);
+    abort_reasons.resize(ntypes, abort_counts());
+  }
 
   ermia::transaction *txn_obj_buf;
   ermia::str_arena *arena;
@@ -227,6 +627,8 @@ class bench_worker : public ermia::thread::Runner {
   // NOTE: inter-transaction interleaving
   ermia::transaction *transactions;
   ermia::str_arena *arenas;
+  coro_batch_tuner batch_tuner;
+  ermia::BatchProbeCache *probe_cache;  // BatchScheduler only
 };
 
 class bench_runner {
@@ -249,6 +651,9 @@ class bench_runner {
   // For command log shipping only
   static std::vector<bench_worker *> cmdlog_redoers;
 
+  // Name/value of every option the run was started with, for --results_json
+  static std::vector<std::pair<std::string, std::string>> settings;
+
   static void measure_read_view_lsn();
 
  protected:
@@ -17,23 +17,42 @@
 
 // Options that are shared by the primary and backup servers
 DEFINE_bool(threadpool, true, "Whether to use ERMIA thread pool (no oversubscription)");
-DEFINE_uint64(arena_size_mb, 4, "Size of transaction arena (private workspace) in MB");
+DEFINE_uint64(arena_size_mb, 4, "Chunk size of transaction arenas (private workspace) in MB; arenas grow a chunk at a time");
+DEFINE_uint64(tls_free_cache_mb, 64, "MBs of freed objects each thread caches before handing batches to its node's depot");
 DEFINE_bool(tls_alloc, true, "Whether to use the TLS allocator defined in sm-alloc.h");
 DEFINE_bool(htt, true, "Whether the HW has hyper-threading enabled."
   "Ignored if auto-detection of physical cores succeeded.");
 DEFINE_bool(physical_workers_only, true, "Whether to only use one thread per physical core as transaction workers.");
 DEFINE_bool(amac_version_chain, false, "Whether to use AMAC for traversing version chain; applicable only for multi-get.");
 DEFINE_bool(coro_tx, false, "Whether to turn each transaction into a coroutine");
-DEFINE_uint64(coro_batch_size, 5, "Number of in-flight coroutines");
+DEFINE_int64(coro_workers, -1, "Number of workers that run coroutine transactions with --coro_tx, "
+  "the rest run the same transactions sequentially; -1 means all workers");
+DEFINE_string(coro_sequential_txns, "", "Comma-separated transaction types that coroutine workers "
+  "run to completion once started instead of interleaving them with the rest of the batch");
+DEFINE_uint64(coro_batch_size, 5, "Number of in-flight coroutines (the maximum if --coro_adaptive_batch)");
+DEFINE_bool(coro_adaptive_batch, false, "Whether to adjust the number of in-flight coroutines online");
+DEFINE_uint64(coro_min_batch_size, 1, "Minimum number of in-flight coroutines for --coro_adaptive_batch");
+DEFINE_uint64(coro_long_txn_interval, 4, "Resume long transactions (scans, queries) only every n scheduling "
+  "rounds while short ones are in flight; 1 treats all transactions the same");
 DEFINE_bool(coro_batch_schedule, false, "Whether to run the same type of transactions per batch");
+DEFINE_bool(coro_batch_probe_cache, true, "Whether transactions in a same-type batch share index probes "
+  "for the same key; needs a BATCH_SAME_TRX build");
 DEFINE_bool(scan_with_iterator, false, "Whether to run scan with iterator version or callback version");
 DEFINE_bool(verbose, true, "Verbose mode.");
 DEFINE_string(benchmark, "tpcc", "Benchmark name: tpcc, tpce, or ycsb");
 DEFINE_string(benchmark_options, "", "Benchmark-specific opetions.");
+DEFINE_bool(tpcc_dora, false, "Run TPC-C on the DORA-style executor that routes each transaction "
+  "to the worker owning its warehouse");
 DEFINE_bool(index_probe_only, false, "Whether the read is only probing into index");
 DEFINE_uint64(threads, 1, "Number of worker threads to run transactions.");
-DEFINE_uint64(node_memory_gb, 12, "GBs of memory to allocate per node.");
+DEFINE_uint64(node_memory_gb, 12, "GBs of memory to allocate per node. Pools are pre-faulted "
+                                  "in the background while loading, and the measured run starts "
+                                  "only once all of it is faulted in on every node.");
+DEFINE_bool(oid_numa_partition, false,
+            "Partition OID arrays into extents bound to the node that allocates "
+            "from them, and hand out OIDs from node-local extents.");
 DEFINE_bool(numa_spread, false, "Whether to pin threads in spread mode (compact if false)");
+DEFINE_string(placement, "", "Thread placement policy, e.g., workers=compact,log=core:0,commit=core:0,chkpt=node:0,rep=node:0");
 DEFINE_string(tmpfs_dir, "/dev/shm",
               "Path to a tmpfs location. Used by log buffer.");
 DEFINE_string(log_data_dir, "/tmpfs/ermia-log", "Log directory.");
@@ -47,8 +66,16 @@ DEFINE_uint64(read_view_stat_interval_ms, 0,
 DEFINE_string(read_view_stat_file, "/dev/shm/ermia_read_view_stat",
   "Where to store all the read view LSN outputs. Recommend tmpfs.");
 DEFINE_bool(print_cpu_util, false, "Whether to print CPU utilization.");
+DEFINE_bool(print_latency_percentiles, false,
+            "Whether to print per-second commit latency percentiles.");
+DEFINE_string(results_json, "", "File to write the settings, per-second samples and "
+  "per-transaction-type results to as JSON; the text output is printed regardless.");
 DEFINE_bool(enable_perf, false, "Whether to run Linux perf along with benchmark.");
 DEFINE_string(perf_record_event, "", "Perf record event");
+DEFINE_bool(work_stealing, false, "Whether idle workers steal other workers' overdue open-loop arrivals (needs --arrival_rate)");
+DEFINE_double(arrival_rate, 0, "Open-loop mode: transactions per second offered over all workers, "
+  "latency counts from each transaction's intended start. 0 runs closed-loop.");
+DEFINE_string(arrival_process, "poisson", "Open-loop arrivals: poisson or constant");
 #if defined(SSN) || defined(SSI)
 DEFINE_bool(safesnap, false,
             "Whether to use the safe snapshot (for SSI and SSN only).");
@@ -160,6 +187,48 @@ static std::vector<std::string> split_ws(const std::string &s) {
   return r;
 }
 
+static const char *cc_scheme() {
+#ifdef SSI
+  return "SSI";
+#elif defined(SSN)
+#ifdef RC
+  return "RC+SSN";
+#else
+  return "SI+SSN";
+#endif
+#elif defined(MVCC)
+  return "MVOCC";
+#else
+  return "SI";
+#endif
+}
+
+// Every dbtest option as it ended up, plus what the build and the machine
+// decided, for the results file
+static void record_settings() {
+  auto &settings = bench_runner::settings;
+  settings.emplace_back("cc", cc_scheme());
+#ifdef ADV_COROUTINE
+  settings.emplace_back("build", "adv_coroutine");
+#else
+  settings.emplace_back("build", "default");
+#endif
+#ifdef NDEBUG
+  settings.emplace_back("debug", "false");
+#else
+  settings.emplace_back("debug", "true");
+#endif
+  std::vector<google::CommandLineFlagInfo> flags;
+  google::GetAllFlags(&flags);
+  for (auto &f : flags) {
+    if (f.filename.find("dbtest.cc") != std::string::npos) {
+      settings.emplace_back(f.name, f.current_value);
+    }
+  }
+  settings.emplace_back("worker_threads", std::to_string(ermia::config::worker_threads));
+  settings.emplace_back("numa_nodes", std::to_string(ermia::config::numa_nodes));
+}
+
 int main(int argc, char **argv) {
 #ifndef NDEBUG
   std::cerr << "WARNING: benchmark built in DEBUG mode!!!" << std::endl;
@@ -174,9 +243,20 @@ int main(int argc, char **argv) {
   ermia::config::benchmark = FLAGS_benchmark;
   ermia::config::state = ermia::config::kStateLoading;
   ermia::config::print_cpu_util = FLAGS_print_cpu_util;
+  ermia::config::print_latency_percentiles = FLAGS_print_latency_percentiles;
+  ermia::config::results_json = FLAGS_results_json;
   ermia::config::htt_is_on = FLAGS_htt;
   ermia::config::enable_perf = FLAGS_enable_perf;
   ermia::config::perf_record_event = FLAGS_perf_record_event;
+  ermia::config::work_stealing = FLAGS_work_stealing;
+  ermia::config::arrival_rate = FLAGS_arrival_rate;
+  if (FLAGS_arrival_process == "poisson") {
+    ermia::config::arrival_poisson = true;
+  } else if (FLAGS_arrival_process == "constant") {
+    ermia::config::arrival_poisson = false;
+  } else {
+    LOG(FATAL) << "Invalid arrival process: " << FLAGS_arrival_process;
+  }
   ermia::config::physical_workers_only = FLAGS_physical_workers_only;
   if (ermia::config::physical_workers_only)
     ermia::config::threads = FLAGS_threads;
@@ -185,7 +265,9 @@ int main(int argc, char **argv) {
   ermia::config::index_probe_only = FLAGS_index_probe_only;
   ermia::config::verbose = FLAGS_verbose;
   ermia::config::node_memory_gb = FLAGS_node_memory_gb;
+  ermia::config::oid_numa_partition = FLAGS_oid_numa_partition;
   ermia::config::numa_spread = FLAGS_numa_spread;
+  ermia::config::placement_policy = FLAGS_placement;
   ermia::config::tmpfs_dir = FLAGS_tmpfs_dir;
   ermia::config::log_dir = FLAGS_log_data_dir;
   ermia::config::log_segment_mb = FLAGS_log_segment_mb;
@@ -218,10 +300,16 @@ int main(int argc, char **argv) {
   ermia::config::command_log_buffer_mb = FLAGS_command_log_buffer_mb;
 
   ermia::config::arena_size_mb = FLAGS_arena_size_mb;
+  ermia::config::tls_free_cache_mb = FLAGS_tls_free_cache_mb;
 
   ermia::config::coro_tx = FLAGS_coro_tx;
+  ermia::config::coro_sequential_txns = FLAGS_coro_sequential_txns;
   ermia::config::coro_batch_size = FLAGS_coro_batch_size;
   ermia::config::coro_batch_schedule = FLAGS_coro_batch_schedule;
+  ermia::config::coro_batch_probe_cache = FLAGS_coro_batch_probe_cache;
+  ermia::config::coro_adaptive_batch = FLAGS_coro_adaptive_batch;
+  ermia::config::coro_min_batch_size = FLAGS_coro_min_batch_size;
+  ermia::config::coro_long_txn_interval = FLAGS_coro_long_txn_interval;
 
   ermia::config::scan_with_it = FLAGS_scan_with_iterator;
 
@@ -292,6 +380,10 @@ int main(int argc, char **argv) {
 
     ermia::config::replay_threads = 0;
     ermia::config::worker_threads = FLAGS_threads;
+    if (ermia::config::coro_tx) {
+      ermia::config::coro_workers =
+        FLAGS_coro_workers < 0 ? ermia::config::worker_threads : FLAGS_coro_workers;
+    }
 
     ermia::config::group_commit = FLAGS_group_commit;
     ermia::config::group_commit_queue_length = FLAGS_group_commit_queue_length;
@@ -364,12 +456,25 @@ int main(int argc, char **argv) {
   std::cerr << "Settings and properties" << std::endl;
   std::cerr << "  amac-version-chain: " << FLAGS_amac_version_chain << std::endl;
   std::cerr << "  arena-size-mb     : " << FLAGS_arena_size_mb << std::endl;
+  if (ermia::config::arrival_rate) {
+    std::cerr << "  arrival-rate      : " << ermia::config::arrival_rate << " txns/s ("
+              << FLAGS_arrival_process << ")" << std::endl;
+  } else {
+    std::cerr << "  arrival-rate      : closed loop" << std::endl;
+  }
+  std::cerr << "  tls-free-cache-mb : " << FLAGS_tls_free_cache_mb << std::endl;
   std::cerr << "  benchmark         : " << FLAGS_benchmark << std::endl;
   std::cerr << "  command-log       : " << ermia::config::command_log << std::endl;
   std::cerr << "  command-logbuf    : " << ermia::config::command_log_buffer_mb << "MB" << std::endl;
   std::cerr << "  coro-tx           : " << FLAGS_coro_tx << std::endl;
+  std::cerr << "  coro-workers      : " << ermia::config::coro_workers << std::endl;
+  std::cerr << "  coro-sequential-txns: " << ermia::config::coro_sequential_txns << std::endl;
   std::cerr << "  coro-batch-schedule: " << FLAGS_coro_batch_schedule << std::endl;
+  std::cerr << "  coro-batch-probe-cache: " << FLAGS_coro_batch_probe_cache << std::endl;
   std::cerr << "  coro-batch-size   : " << FLAGS_coro_batch_size << std::endl;
+  std::cerr << "  coro-adaptive-batch: " << FLAGS_coro_adaptive_batch << std::endl;
+  std::cerr << "  coro-min-batch-size: " << FLAGS_coro_min_batch_size << std::endl;
+  std::cerr << "  coro-long-txn-interval: " << FLAGS_coro_long_txn_interval << std::endl;
   std::cerr << "  scan-use-iterator : " << FLAGS_scan_with_iterator << std::endl;
   std::cerr << "  enable-perf       : " << ermia::config::enable_perf << std::endl;
   std::cerr << "  index-probe-only  : " << FLAGS_index_probe_only << std::endl;
@@ -381,17 +486,22 @@ int main(int argc, char **argv) {
   std::cerr << "  masstree_internal_node_size: " << ermia::ConcurrentMasstree::InternalNodeSize() << std::endl;
   std::cerr << "  masstree_leaf_node_size    : " << ermia::ConcurrentMasstree::LeafNodeSize() << std::endl;
   std::cerr << "  node-memory       : " << ermia::config::node_memory_gb << "GB" << std::endl;
+  std::cerr << "  oid-numa-partition: " << ermia::config::oid_numa_partition << std::endl;
   std::cerr << "  num-threads       : " << ermia::config::threads << std::endl;
   std::cerr << "  numa-nodes        : " << ermia::config::numa_nodes << std::endl;
   std::cerr << "  numa-mode         : " << (ermia::config::numa_spread ? "spread" : "compact") << std::endl;
+  ermia::thread::PrintPlacement(std::cerr);
   std::cerr << "  perf-record-event : " << ermia::config::perf_record_event << std::endl;
   std::cerr << "  persist-policy    : " << FLAGS_persist_policy << std::endl;
   std::cerr << "  physical-workers-only: " << ermia::config::physical_workers_only << std::endl;
   std::cerr << "  print-cpu-util    : " << ermia::config::print_cpu_util << std::endl;
+  std::cerr << "  print-latency-percentiles: " << ermia::config::print_latency_percentiles << std::endl;
+  std::cerr << "  results-json      : " << ermia::config::results_json << std::endl;
   std::cerr << "  read_view_stat_interval : " << ermia::config::read_view_stat_interval_ms << "ms" << std::endl;
   std::cerr << "  read_view_stat_file     : " << ermia::config::read_view_stat_file << std::endl;
   std::cerr << "  threadpool        : " << ermia::config::threadpool << std::endl;
   std::cerr << "  tmpfs-dir         : " << ermia::config::tmpfs_dir << std::endl;
+  std::cerr << "  tpcc-dora         : " << FLAGS_tpcc_dora << std::endl;
   std::cerr << "  tls-alloc         : " << FLAGS_tls_alloc << std::endl;
   std::cerr << "  total-threads     : " << ermia::config::threads << std::endl;
 #ifdef USE_VARINT_ENCODING
@@ -399,6 +509,7 @@ int main(int argc, char **argv) {
 #else
   std::cerr << "  var-encode        : no" << std::endl;
 #endif
+  std::cerr << "  work-stealing     : " << ermia::config::work_stealing << std::endl;
   std::cerr << "  worker-threads    : " << ermia::config::worker_threads << std::endl;
 
   if (ermia::config::is_backup_srv()) {
@@ -455,15 +566,23 @@ int main(int argc, char **argv) {
 #endif
   } else if (FLAGS_benchmark == "tpcc") {
 #ifndef ADV_COROUTINE
-    test_fn = tpcc_do_test;
+    test_fn = FLAGS_tpcc_dora ? tpcc_dora_do_test : tpcc_do_test;
 #else
     LOG(FATAL) << "Not supported in this build";
 #endif
   } else if (FLAGS_benchmark == "tpce") {
+#ifndef ADV_COROUTINE
+    // Coroutine-mode runs can still host TPC-E on sequential workers
+    LOG_IF(FATAL, ermia::config::coro_workers)
+      << "TPC-E has no coroutine transactions, run it with --coro_workers=0";
+    test_fn = tpce_do_test;
+#else
     LOG(FATAL) << "Not supported in this build";
+#endif
   } else {
     LOG(FATAL) << "Invalid benchmark: " << FLAGS_benchmark;
   }
+  record_settings();
 
   // FIXME(tzwang): the current thread doesn't belong to the thread pool, and
   // it could be on any node. But not all nodes will be used by benchmark
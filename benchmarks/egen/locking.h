@@ -64,13 +64,13 @@ class Locker
         T& mutex_;
 
     public:
-        explicit Locker<T>(T& mutex)
+        explicit Locker(T& mutex)
             : mutex_(mutex)
         {
             mutex_.lock();
         }
 
-        ~Locker<T>() {
+        ~Locker() {
             mutex_.unlock();
         }
 };
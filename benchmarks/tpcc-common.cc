@@ -305,15 +305,16 @@ class tpcc_bench_runner : public bench_runner {
   virtual std::vector<bench_worker *> make_workers() {
     util::fast_random r(23984543);
     std::vector<bench_worker *> ret;
-    if (NumWarehouses() <= ermia::config::worker_threads) {
-      for (size_t i = 0; i < ermia::config::worker_threads; i++)
-        ret.push_back(new WorkerType(i, r.next(), db, open_tables, partitions,
-                                    &barrier_a, &barrier_b,
-                                    (i % NumWarehouses()) + 1));
-    } else {
-      for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+    for (size_t i = 0; i < ermia::config::worker_threads; i++) {
+      uint home_warehouse_id = NumWarehouses() <= ermia::config::worker_threads ?
+                               (i % NumWarehouses()) + 1 : i + 1;
+      // Workers beyond --coro_workers run the sequential version
+      if (ermia::config::coro_tx && i >= ermia::config::coro_workers) {
+        ret.push_back(new tpcc_worker(i, r.next(), db, open_tables, partitions,
+                                      &barrier_a, &barrier_b, home_warehouse_id));
+      } else {
         ret.push_back(new WorkerType(i, r.next(), db, open_tables, partitions,
-                                     &barrier_a, &barrier_b, i + 1));
+                                     &barrier_a, &barrier_b, home_warehouse_id));
       }
     }
     return ret;
@@ -338,7 +339,7 @@ class tpcc_bench_runner : public bench_runner {
 
 
 
-void tpcc_do_test(ermia::Engine *db, int argc, char **argv) {
+static void tpcc_parse_options(int argc, char **argv) {
   // parse options
   optind = 1;
   bool did_spec_remote_pct = false;
@@ -479,7 +480,10 @@ void tpcc_do_test(ermia::Engine *db, int argc, char **argv) {
                         g_txn_workload_mix + ARRAY_NELEMS(g_txn_workload_mix))
          << std::endl;
   }
+}
 
+void tpcc_do_test(ermia::Engine *db, int argc, char **argv) {
+  tpcc_parse_options(argc, argv);
   if (ermia::config::coro_tx) {
     tpcc_bench_runner<tpcc_cs_worker> r(db);
     r.run();
@@ -488,4 +492,18 @@ void tpcc_do_test(ermia::Engine *db, int argc, char **argv) {
     r.run();
   }
 }
+
+void tpcc_dora_do_test(ermia::Engine *db, int argc, char **argv) {
+  LOG_IF(FATAL, ermia::config::coro_tx) << "DORA runs sequential transactions only";
+  LOG_IF(FATAL, ermia::config::work_stealing) << "DORA workers only run what they own";
+  LOG_IF(FATAL, NumWarehouses() < ermia::config::worker_threads)
+    << "DORA needs at least one warehouse per worker";
+  tpcc_parse_options(argc, argv);
+  LOG_IF(WARNING, ermia::config::command_log || (!g_wh_temperature && g_wh_spread == 0))
+    << "DORA: every transaction runs on its home warehouse with these settings, so none "
+    << "will be routed; use --warehouse-spread or --80-20-dist to exercise routing";
+  tpcc_bench_runner<tpcc_dora_worker> r(db);
+  r.run();
+  tpcc_dora_worker::PrintRoutingStats(std::cout);
+}
 #endif // ADV_COROUTINE
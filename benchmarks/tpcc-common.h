@@ -1206,39 +1206,45 @@ class tpcc_worker : public bench_worker, public tpcc_worker_mixin {
   // XXX(stephentu): tune this
   static const size_t NMaxCustomerIdxScanElems = 512;
 
-  rc_t txn_new_order();
+  rc_t txn_new_order(uint warehouse_id);
 
   static rc_t TxnNewOrder(bench_worker *w) {
-    return static_cast<tpcc_worker *>(w)->txn_new_order();
+    auto *t = static_cast<tpcc_worker *>(w);
+    return t->txn_new_order(t->txn_warehouse());
   }
 
-  rc_t txn_delivery();
+  rc_t txn_delivery(uint warehouse_id);
 
   static rc_t TxnDelivery(bench_worker *w) {
-    return static_cast<tpcc_worker *>(w)->txn_delivery();
+    auto *t = static_cast<tpcc_worker *>(w);
+    return t->txn_delivery(t->txn_warehouse());
   }
 
-  rc_t txn_credit_check();
+  rc_t txn_credit_check(uint warehouse_id);
   static rc_t TxnCreditCheck(bench_worker *w) {
-    return static_cast<tpcc_worker *>(w)->txn_credit_check();
+    auto *t = static_cast<tpcc_worker *>(w);
+    return t->txn_credit_check(t->txn_warehouse());
   }
 
-  rc_t txn_payment();
+  rc_t txn_payment(uint warehouse_id);
 
   static rc_t TxnPayment(bench_worker *w) {
-    return static_cast<tpcc_worker *>(w)->txn_payment();
+    auto *t = static_cast<tpcc_worker *>(w);
+    return t->txn_payment(t->txn_warehouse());
   }
 
-  rc_t txn_order_status();
+  rc_t txn_order_status(uint warehouse_id);
 
   static rc_t TxnOrderStatus(bench_worker *w) {
-    return static_cast<tpcc_worker *>(w)->txn_order_status();
+    auto *t = static_cast<tpcc_worker *>(w);
+    return t->txn_order_status(t->txn_warehouse());
   }
 
-  rc_t txn_stock_level();
+  rc_t txn_stock_level(uint warehouse_id);
 
   static rc_t TxnStockLevel(bench_worker *w) {
-    return static_cast<tpcc_worker *>(w)->txn_stock_level();
+    auto *t = static_cast<tpcc_worker *>(w);
+    return t->txn_stock_level(t->txn_warehouse());
   }
 
   rc_t txn_microbench_random();
@@ -1258,15 +1264,128 @@ class tpcc_worker : public bench_worker, public tpcc_worker_mixin {
   }
 
   virtual workload_desc_vec get_workload() const override;
+  virtual uint32_t home() const override { return home_warehouse_id; }
 
  protected:
   ALWAYS_INLINE ermia::varstr &str(uint64_t size) { return *arena->next(size); }
 
+  // Warehouse the next transaction runs against, drawn before its other inputs
+  virtual uint txn_warehouse() { return pick_wh(r, request_home()); }
+
  private:
   const uint home_warehouse_id;
   int32_t last_no_o_ids[10];  // XXX(stephentu): hack
 };
 
+// A transaction routed to the worker owning its warehouse, which it then
+// runs against; the seed gives its other inputs.
+struct dora_request {
+  txn_request req;
+  uint warehouse_id;
+  uint64_t intended_us;  // open-loop intended start, 0 if closed-loop
+};
+
+// Bounded multi-producer, single-consumer queue of routed requests (Vyukov's
+// bounded queue with a single consumer). Every worker may push, only the
+// owner pops.
+class dora_inbox {
+ public:
+  static const uint64_t kCapacity = 1024;  // must be a power of two
+
+  dora_inbox() : head_(0), tail_(0) {
+    for (uint64_t i = 0; i < kCapacity; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Any thread; false if full
+  inline bool push(const dora_request &req) {
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      cell &c = cells_[pos & (kCapacity - 1)];
+      int64_t diff = (int64_t)c.seq.load(std::memory_order_acquire) - (int64_t)pos;
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.req = req;
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Owner only
+  inline bool pop(dora_request &out) {
+    cell &c = cells_[head_ & (kCapacity - 1)];
+    if ((int64_t)c.seq.load(std::memory_order_acquire) - (int64_t)(head_ + 1) < 0) {
+      return false;
+    }
+    out = c.req;
+    c.seq.store(head_ + kCapacity, std::memory_order_release);
+    ++head_;
+    return true;
+  }
+
+ private:
+  struct cell {
+    std::atomic<uint64_t> seq;
+    dora_request req;
+  };
+  uint64_t head_ CACHE_ALIGNED;
+  std::atomic<uint64_t> tail_ CACHE_ALIGNED;
+  cell cells_[kCapacity] CACHE_ALIGNED;
+};
+
+// Data-oriented (DORA-style) partitioned executor: each worker owns a
+// contiguous range of warehouses and is the only one running transactions
+// whose home warehouse is in it. Workers also act as clients, generating
+// requests for warehouses picked as usual (--warehouse-spread, --80-20-dist)
+// and routing those owned by others to the owner's inbox. Remote-warehouse
+// accesses within a transaction (e.g., remote stock in NewOrder) still run
+// on the owner under the engine's concurrency control.
+class tpcc_dora_worker : public tpcc_worker {
+ public:
+  tpcc_dora_worker(unsigned int worker_id, unsigned long seed, ermia::Engine *db,
+                   const std::map<std::string, ermia::OrderedIndex *> &open_tables,
+                   const std::map<std::string, std::vector<ermia::OrderedIndex *>> &partitions,
+                   spin_barrier *barrier_a, spin_barrier *barrier_b,
+                   uint home_warehouse_id);
+
+  virtual void MyWork(char *) override;
+  virtual const char *execution_mode() const override { return "dora"; }
+
+  // Worker ID owning warehouse [w], same grouping as per-partition trees
+  static uint PartitionOf(uint w);
+  // First warehouse owned by [worker_id]
+  static uint PartitionStart(uint worker_id);
+  static void PrintRoutingStats(std::ostream &os);
+
+ protected:
+  virtual uint txn_warehouse() override { return executing->warehouse_id; }
+
+ private:
+  // Routed requests served per round before generating our own
+  static const uint32_t kInboxBatch = 8;
+  // Longest an open-loop worker with nothing due sleeps before checking
+  // its inbox again
+  static const uint64_t kInboxPollUs = 20;
+
+  dora_request make_request();
+  void execute(const dora_request &req);
+  void route(tpcc_dora_worker *owner, const dora_request &req);
+
+  const uint partition_start;  // first owned warehouse
+  uint partition_size;         // number of owned warehouses
+  const dora_request *executing;
+  size_t ntxn_local;
+  size_t ntxn_routed;
+  dora_inbox inbox;
+};
+
 class tpcc_cs_worker : public bench_worker, public tpcc_worker_mixin {
  public:
   tpcc_cs_worker(unsigned int worker_id, unsigned long seed, ermia::Engine *db,
@@ -1277,40 +1396,54 @@ class tpcc_cs_worker : public bench_worker, public tpcc_worker_mixin {
   // XXX(stephentu): tune this
   static const size_t NMaxCustomerIdxScanElems = 512;
 
-  ermia::coro::generator<rc_t> txn_new_order(uint32_t idx, ermia::epoch_num begin_epoch);
+  // [home_wh] is passed in because the lazy bodies only draw their inputs
+  // once resumed, when request_home() may already be the next request's
+  ermia::coro::generator<rc_t> txn_new_order(uint32_t idx, ermia::epoch_num begin_epoch,
+                                             uint home_wh);
 
   static ermia::coro::generator<rc_t> TxnNewOrder(bench_worker *w, uint32_t idx, ermia::epoch_num begin_epoch) {
-    return static_cast<tpcc_cs_worker *>(w)->txn_new_order(idx, begin_epoch);
+    auto *t = static_cast<tpcc_cs_worker *>(w);
+    return t->txn_new_order(idx, begin_epoch, t->request_home());
   }
 
-  ermia::coro::generator<rc_t> txn_delivery(uint32_t idx, ermia::epoch_num begin_epoch);
+  ermia::coro::generator<rc_t> txn_delivery(uint32_t idx, ermia::epoch_num begin_epoch,
+                                            uint home_wh);
 
   static ermia::coro::generator<rc_t> TxnDelivery(bench_worker *w, uint32_t idx, ermia::epoch_num begin_epoch) {
-    return static_cast<tpcc_cs_worker *>(w)->txn_delivery(idx, begin_epoch);
+    auto *t = static_cast<tpcc_cs_worker *>(w);
+    return t->txn_delivery(idx, begin_epoch, t->request_home());
   }
 
-  ermia::coro::generator<rc_t> txn_credit_check(uint32_t idx, ermia::epoch_num begin_epoch);
+  ermia::coro::generator<rc_t> txn_credit_check(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                uint home_wh);
 
   static ermia::coro::generator<rc_t> TxnCreditCheck(bench_worker *w, uint32_t idx, ermia::epoch_num begin_epoch) {
-    return static_cast<tpcc_cs_worker *>(w)->txn_credit_check(idx, begin_epoch);
+    auto *t = static_cast<tpcc_cs_worker *>(w);
+    return t->txn_credit_check(idx, begin_epoch, t->request_home());
   }
 
-  ermia::coro::generator<rc_t> txn_payment(uint32_t idx, ermia::epoch_num begin_epoch);
+  ermia::coro::generator<rc_t> txn_payment(uint32_t idx, ermia::epoch_num begin_epoch,
+                                           uint home_wh);
 
   static ermia::coro::generator<rc_t> TxnPayment(bench_worker *w, uint32_t idx, ermia::epoch_num begin_epoch) {
-    return static_cast<tpcc_cs_worker *>(w)->txn_payment(idx, begin_epoch);
+    auto *t = static_cast<tpcc_cs_worker *>(w);
+    return t->txn_payment(idx, begin_epoch, t->request_home());
   }
 
-  ermia::coro::generator<rc_t> txn_order_status(uint32_t idx, ermia::epoch_num begin_epoch);
+  ermia::coro::generator<rc_t> txn_order_status(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                uint home_wh);
 
   static ermia::coro::generator<rc_t> TxnOrderStatus(bench_worker *w, uint32_t idx, ermia::epoch_num begin_epoch) {
-    return static_cast<tpcc_cs_worker *>(w)->txn_order_status(idx, begin_epoch);
+    auto *t = static_cast<tpcc_cs_worker *>(w);
+    return t->txn_order_status(idx, begin_epoch, t->request_home());
   }
 
-  ermia::coro::generator<rc_t> txn_stock_level(uint32_t idx, ermia::epoch_num begin_epoch);
+  ermia::coro::generator<rc_t> txn_stock_level(uint32_t idx, ermia::epoch_num begin_epoch,
+                                               uint home_wh);
 
   static ermia::coro::generator<rc_t> TxnStockLevel(bench_worker *w, uint32_t idx, ermia::epoch_num begin_epoch) {
-    return static_cast<tpcc_cs_worker *>(w)->txn_stock_level(idx, begin_epoch);
+    auto *t = static_cast<tpcc_cs_worker *>(w);
+    return t->txn_stock_level(idx, begin_epoch, t->request_home());
   }
 
   ermia::coro::generator<rc_t> txn_query2(uint32_t idx, ermia::epoch_num begin_epoch);
@@ -1331,6 +1464,8 @@ class tpcc_cs_worker : public bench_worker, public tpcc_worker_mixin {
 
   virtual workload_desc_vec get_workload() const override;
   virtual void MyWork(char *) override;
+  virtual const char *execution_mode() const override { return "2-level-coroutine"; }
+  virtual uint32_t home() const override { return home_warehouse_id; }
 
  protected:
   ALWAYS_INLINE ermia::varstr &str(ermia::str_arena &a, uint64_t size) { return *a.next(size); }
@@ -7,8 +7,9 @@
 
 #include "tpcc-common.h"
 
-ermia::coro::generator<rc_t> tpcc_cs_worker::txn_new_order(uint32_t idx, ermia::epoch_num begin_epoch) {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+ermia::coro::generator<rc_t> tpcc_cs_worker::txn_new_order(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                           uint home_wh) {
+  const uint warehouse_id = pick_wh(r, home_wh);
   const uint districtID = RandomNumber(r, 1, 10);
   const uint customerID = GetCustomerId(r);
   const uint numItems = RandomNumber(r, 5, 15);
@@ -270,8 +271,9 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_new_order(uint32_t idx, ermia::
   co_return {RC_TRUE};
 }  // new-order
 
-ermia::coro::generator<rc_t> tpcc_cs_worker::txn_payment(uint32_t idx, ermia::epoch_num begin_epoch) {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+ermia::coro::generator<rc_t> tpcc_cs_worker::txn_payment(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                         uint home_wh) {
+  const uint warehouse_id = pick_wh(r, home_wh);
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
   uint customerDistrictID, customerWarehouseID;
   if (likely(g_disable_xpartition_txn || NumWarehouses() == 1 ||
@@ -438,7 +440,8 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_payment(uint32_t idx, ermia::ep
   co_return {RC_TRUE};
 }  // payment
 
-ermia::coro::generator<rc_t> tpcc_cs_worker::txn_delivery(uint32_t idx, ermia::epoch_num begin_epoch) {
+ermia::coro::generator<rc_t> tpcc_cs_worker::txn_delivery(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                          uint home_wh) {
   ermia::transaction *txn = db->NewTransaction(ermia::transaction::TXN_FLAG_CSWITCH,
                                                arenas[idx],
                                                &transactions[idx],
@@ -447,7 +450,7 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_delivery(uint32_t idx, ermia::e
   xc->begin_epoch = begin_epoch;
   rc_t rc = rc_t{RC_INVALID};
 
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+  const uint warehouse_id = pick_wh(r, home_wh);
   const uint o_carrier_id = RandomNumber(r, 1, NumDistrictsPerWarehouse());
   const uint32_t ts = GetCurrentTimeMillis();
 
@@ -574,7 +577,8 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_delivery(uint32_t idx, ermia::e
   co_return {RC_TRUE};
 }  // delivery
 
-ermia::coro::generator<rc_t> tpcc_cs_worker::txn_order_status(uint32_t idx, ermia::epoch_num begin_epoch) {
+ermia::coro::generator<rc_t> tpcc_cs_worker::txn_order_status(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                              uint home_wh) {
   const uint64_t read_only_mask =
       ermia::config::enable_safesnap ? ermia::transaction::TXN_FLAG_READ_ONLY : 0;
   // NB: since txn_order_status() is a RO txn, we assume that
@@ -587,7 +591,7 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_order_status(uint32_t idx, ermi
   xc->begin_epoch = begin_epoch;
   rc_t rc = rc_t{RC_INVALID};
 
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+  const uint warehouse_id = pick_wh(r, home_wh);
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
 
   // output from txn counters:
@@ -713,7 +717,8 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_order_status(uint32_t idx, ermi
   co_return {RC_TRUE};
 }  // order-status
 
-ermia::coro::generator<rc_t> tpcc_cs_worker::txn_stock_level(uint32_t idx, ermia::epoch_num begin_epoch) {
+ermia::coro::generator<rc_t> tpcc_cs_worker::txn_stock_level(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                             uint home_wh) {
   const uint64_t read_only_mask =
       ermia::config::enable_safesnap ? ermia::transaction::TXN_FLAG_READ_ONLY : 0;
   // NB: since txn_stock_level() is a RO txn, we assume that
@@ -726,7 +731,7 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_stock_level(uint32_t idx, ermia
   xc->begin_epoch = begin_epoch;
   rc_t rc = rc_t{RC_INVALID};
 
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+  const uint warehouse_id = pick_wh(r, home_wh);
   const uint threshold = RandomNumber(r, 10, 20);
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
 
@@ -833,7 +838,8 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_stock_level(uint32_t idx, ermia
   co_return {RC_TRUE};
 }  // stock-level
 
-ermia::coro::generator<rc_t> tpcc_cs_worker::txn_credit_check(uint32_t idx, ermia::epoch_num begin_epoch) {
+ermia::coro::generator<rc_t> tpcc_cs_worker::txn_credit_check(uint32_t idx, ermia::epoch_num begin_epoch,
+                                                              uint home_wh) {
   /*
           Note: Cahill's credit check transaction to introduce SI's anomaly.
 
@@ -866,7 +872,7 @@ ermia::coro::generator<rc_t> tpcc_cs_worker::txn_credit_check(uint32_t idx, ermi
   xc->begin_epoch = begin_epoch;
   rc_t rc = rc_t{RC_INVALID};
 
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+  const uint warehouse_id = pick_wh(r, home_wh);
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
   uint customerDistrictID, customerWarehouseID;
   if (likely(g_disable_xpartition_txn || NumWarehouses() == 1 ||
@@ -1294,7 +1300,7 @@ bench_worker::workload_desc_vec tpcc_cs_worker::get_workload() const {
         "StockLevel", double(g_txn_workload_mix[5]) / 100.0, nullptr, TxnStockLevel));
   if (g_txn_workload_mix[6])
     w.push_back(workload_desc(
-        "Query2", double(g_txn_workload_mix[6]) / 100.0, nullptr, TxnQuery2));
+        "Query2", double(g_txn_workload_mix[6]) / 100.0, nullptr, TxnQuery2).long_running());
   if (g_txn_workload_mix[7])
     w.push_back(workload_desc(
         "MicroBenchRandom", double(g_txn_workload_mix[7]) / 100.0, nullptr, TxnMicroBenchRandom));
@@ -1306,7 +1312,7 @@ void tpcc_cs_worker::MyWork(char *) {
   // No replication support
   ALWAYS_ASSERT(is_worker);
   workload = get_workload();
-  txn_counts.resize(workload.size());
+  init_txn_stats(workload.size());
 
   if (ermia::config::coro_batch_schedule) {
     //PipelineScheduler();
@@ -7,8 +7,7 @@
 
 #include "tpcc-common.h"
 
-rc_t tpcc_worker::txn_new_order() {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+rc_t tpcc_worker::txn_new_order(uint warehouse_id) {
   const uint districtID = RandomNumber(r, 1, 10);
   const uint customerID = GetCustomerId(r);
   const uint numItems = RandomNumber(r, 5, 15);
@@ -191,8 +190,7 @@ rc_t tpcc_worker::txn_new_order() {
   return {RC_TRUE};
 }  // new-order
 
-rc_t tpcc_worker::txn_payment() {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+rc_t tpcc_worker::txn_payment(uint warehouse_id) {
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
   uint customerDistrictID, customerWarehouseID;
   if (likely(g_disable_xpartition_txn || NumWarehouses() == 1 ||
@@ -377,8 +375,7 @@ rc_t tpcc_worker::txn_payment() {
   return {RC_TRUE};
 }
 
-rc_t tpcc_worker::txn_delivery() {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+rc_t tpcc_worker::txn_delivery(uint warehouse_id) {
   const uint o_carrier_id = RandomNumber(r, 1, NumDistrictsPerWarehouse());
   const uint32_t ts = GetCurrentTimeMillis();
 
@@ -499,8 +496,7 @@ rc_t tpcc_worker::txn_delivery() {
   return {RC_TRUE};
 }
 
-rc_t tpcc_worker::txn_order_status() {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+rc_t tpcc_worker::txn_order_status(uint warehouse_id) {
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
 
   // output from txn counters:
@@ -623,8 +619,7 @@ rc_t tpcc_worker::txn_order_status() {
   return {RC_TRUE};
 }
 
-rc_t tpcc_worker::txn_stock_level() {
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
+rc_t tpcc_worker::txn_stock_level(uint warehouse_id) {
   const uint threshold = RandomNumber(r, 10, 20);
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
 
@@ -694,7 +689,7 @@ rc_t tpcc_worker::txn_stock_level() {
   return {RC_TRUE};
 }
 
-rc_t tpcc_worker::txn_credit_check() {
+rc_t tpcc_worker::txn_credit_check(uint warehouse_id) {
   /*
           Note: Cahill's credit check transaction to introduce SI's anomaly.
 
@@ -720,7 +715,6 @@ rc_t tpcc_worker::txn_credit_check() {
           WHERE c_id = :c_id AND c_d_id = :d_id AND c_w_id = :w_id
   */
 
-  const uint warehouse_id = pick_wh(r, home_warehouse_id);
   const uint districtID = RandomNumber(r, 1, NumDistrictsPerWarehouse());
   uint customerDistrictID, customerWarehouseID;
   if (likely(g_disable_xpartition_txn || NumWarehouses() == 1 ||
@@ -1074,7 +1068,7 @@ bench_worker::workload_desc_vec tpcc_worker::get_workload() const {
         "StockLevel", double(g_txn_workload_mix[5]) / 100.0, TxnStockLevel));
   if (g_txn_workload_mix[6])
     w.push_back(workload_desc("Query2", double(g_txn_workload_mix[6]) / 100.0,
-                              TxnQuery2));
+                              TxnQuery2).long_running());
   if (g_txn_workload_mix[7])
     w.push_back(workload_desc("MicroBenchRandom",
                               double(g_txn_workload_mix[7]) / 100.0,
@@ -7,12 +7,19 @@ uint g_reps_per_tx = 1;
 uint g_rmw_additional_reads = 0;
 char g_workload = 'C';
 uint g_initial_table_size = 30000000;
-int g_zipfian_rng = 0;
+int g_zipfian_rng = 0;  // --zipfian, same as --distribution=zipfian
 double g_zipfian_theta = 0.99;  // zipfian constant, [0, 1), more skewed as it approaches 1.
-
-
-// TODO: support scan_min length, current zipfain rng does not support min bound.
-const int g_scan_min_length = 1;
+KeyDistribution g_key_distribution = KeyDistribution::Uniform;
+double g_hotspot_fraction = 0.2;
+double g_hotspot_probability = 0.8;
+uint g_key_size = 8;
+uint g_value_size = 8;
+uint g_value_size_max = 0;  // 0: same as g_value_size
+uint g_fields = 1;
+int g_read_all_fields = 1;
+int g_write_all_fields = 0;
+
+int g_scan_min_length = 1;
 int g_scan_max_length = 1000;
 int g_scan_length_zipfain_rng = 0;
 double g_scan_length_zipfain_theta = 0.99;
@@ -59,12 +66,15 @@ void ycsb_usertable_loader::load() {
 
   ermia::transaction *txn = db->NewTransaction(0, *arena, txn_buf());
   for (uint64_t i = 0; i < to_insert; ++i) {
-    ermia::varstr &k = str(sizeof(ycsb_kv::key));
+    ermia::varstr &k = str(g_key_size);
     BuildKey(start_key + i, k);
 
-    ermia::varstr &v = str(sizeof(ycsb_kv::value));
-    new (&v) ermia::varstr((char *)&v + sizeof(ermia::varstr), sizeof(ycsb_kv::value));
-    *(char*)v.p = 'a';
+    uint32_t value_size = g_value_size;
+    if (g_value_size_max > g_value_size) {
+      value_size += r.next() % (g_value_size_max - g_value_size + 1);
+    }
+    ermia::varstr &v = str(value_size);
+    WriteFields(v, kYcsbAllFields);
 
 #ifdef ADV_COROUTINE
     TryVerifyStrict(sync_wait_coro(tbl->InsertRecord(txn, k, v)));
@@ -84,7 +94,7 @@ void ycsb_usertable_loader::load() {
   txn = db->NewTransaction(0, *arena, txn_buf());
   for (uint64_t i = 0; i < to_insert; ++i) {
     rc_t rc = rc_t{RC_INVALID};
-    ermia::varstr &k = str(sizeof(ycsb_kv::key));
+    ermia::varstr &k = str(g_key_size);
     BuildKey(start_key + i, k);
     ermia::varstr &v = str(0);
 #ifdef ADV_COROUTINE
@@ -109,6 +119,17 @@ void ycsb_usertable_loader::load() {
   }
 }
 
+static const char *key_distribution_name(KeyDistribution d) {
+  switch (d) {
+    case KeyDistribution::Zipfian: return "zipfian";
+    case KeyDistribution::ScrambledZipfian: return "scrambled zipfian";
+    case KeyDistribution::Latest: return "latest";
+    case KeyDistribution::Hotspot: return "hotspot";
+    case KeyDistribution::Sequential: return "sequential";
+    default: return "uniform";
+  }
+}
+
 void ycsb_parse_options(int argc, char **argv) {
   // parse options
   optind = 1;
@@ -121,11 +142,22 @@ void ycsb_parse_options(int argc, char **argv) {
         {"zipfian", no_argument, &g_zipfian_rng, 1},
         {"zipfian-theta", required_argument, 0, 'z'},
         {"read-tx-type", required_argument, 0, 't'},
+        {"distribution", required_argument, 0, 'd'},
+        {"hotspot-fraction", required_argument, 0, 'h'},
+        {"hotspot-probability", required_argument, 0, 'p'},
         {"scan-range", required_argument, 0, 'g'},
+        {"scan-min-length", required_argument, 0, 'm'},
+        {"scan-length-zipfian", no_argument, &g_scan_length_zipfain_rng, 1},
+        {"key-size", required_argument, 0, 'k'},
+        {"value-size", required_argument, 0, 'v'},
+        {"value-size-max", required_argument, 0, 'V'},
+        {"fields", required_argument, 0, 'f'},
+        {"read-one-field", no_argument, &g_read_all_fields, 0},
+        {"write-all-fields", no_argument, &g_write_all_fields, 1},
         {0, 0, 0, 0}};
 
     int option_index = 0;
-    int c = getopt_long(argc, argv, "r:a:w:s:z:t:g:", long_options, &option_index);
+    int c = getopt_long(argc, argv, "r:a:w:s:z:t:d:h:p:g:m:k:v:V:f:", long_options, &option_index);
     if (c == -1) break;
     switch (c) {
       case 0:
@@ -155,6 +187,32 @@ void ycsb_parse_options(int argc, char **argv) {
         g_zipfian_theta = strtod(optarg, NULL);
         break;
 
+      case 'd':
+        if (std::string(optarg) == "uniform") {
+          g_key_distribution = KeyDistribution::Uniform;
+        } else if (std::string(optarg) == "zipfian") {
+          g_key_distribution = KeyDistribution::Zipfian;
+        } else if (std::string(optarg) == "scrambled-zipfian") {
+          g_key_distribution = KeyDistribution::ScrambledZipfian;
+        } else if (std::string(optarg) == "latest") {
+          g_key_distribution = KeyDistribution::Latest;
+        } else if (std::string(optarg) == "hotspot") {
+          g_key_distribution = KeyDistribution::Hotspot;
+        } else if (std::string(optarg) == "sequential") {
+          g_key_distribution = KeyDistribution::Sequential;
+        } else {
+          LOG(FATAL) << "Wrong key distribution " << std::string(optarg);
+        }
+        break;
+
+      case 'h':
+        g_hotspot_fraction = strtod(optarg, NULL);
+        break;
+
+      case 'p':
+        g_hotspot_probability = strtod(optarg, NULL);
+        break;
+
       case 'r':
         g_reps_per_tx = strtoul(optarg, NULL, 10);
         break;
@@ -195,6 +253,26 @@ void ycsb_parse_options(int argc, char **argv) {
         g_scan_max_length = strtoul(optarg, NULL, 10);
         break;
 
+      case 'm':
+        g_scan_min_length = strtoul(optarg, NULL, 10);
+        break;
+
+      case 'k':
+        g_key_size = strtoul(optarg, NULL, 10);
+        break;
+
+      case 'v':
+        g_value_size = strtoul(optarg, NULL, 10);
+        break;
+
+      case 'V':
+        g_value_size_max = strtoul(optarg, NULL, 10);
+        break;
+
+      case 'f':
+        g_fields = strtoul(optarg, NULL, 10);
+        break;
+
       case '?':
         /* getopt_long already printed an error message. */
         exit(1);
@@ -205,6 +283,20 @@ void ycsb_parse_options(int argc, char **argv) {
   }
 
   ALWAYS_ASSERT(g_initial_table_size);
+  if (g_zipfian_rng) {
+    g_key_distribution = KeyDistribution::Zipfian;
+  }
+  LOG_IF(FATAL, g_hotspot_fraction <= 0 || g_hotspot_fraction > 1) << "Hot set fraction must be in (0, 1]";
+  LOG_IF(FATAL, g_hotspot_probability < 0 || g_hotspot_probability > 1) << "Hot set probability must be in [0, 1]";
+  LOG_IF(FATAL, g_scan_min_length < 1 || g_scan_max_length < g_scan_min_length)
+    << "Invalid scan range [" << g_scan_min_length << ", " << g_scan_max_length << "]";
+  if (!g_value_size_max) {
+    g_value_size_max = g_value_size;
+  }
+  LOG_IF(FATAL, g_key_size < sizeof(uint64_t)) << "Keys need at least " << sizeof(uint64_t) << " bytes";
+  LOG_IF(FATAL, g_value_size_max < g_value_size)
+    << "Invalid value size range [" << g_value_size << ", " << g_value_size_max << "]";
+  LOG_IF(FATAL, !g_fields || g_fields > g_value_size) << "Each of the " << g_fields << " fields needs a byte";
 
   if (ermia::config::verbose) {
     std::cerr << "ycsb settings:" << std::endl
@@ -212,7 +304,16 @@ void ycsb_parse_options(int argc, char **argv) {
          << "  initial user table size:    " << g_initial_table_size << std::endl
          << "  operations per transaction: " << g_reps_per_tx << std::endl
          << "  additional reads after RMW: " << g_rmw_additional_reads << std::endl
-         << "  distribution:               " << (g_zipfian_rng ? "zipfian" : "uniform") << std::endl;
+         << "  distribution:               " << key_distribution_name(g_key_distribution) << std::endl
+         << "  key size:                   " << g_key_size << std::endl
+         << "  value size:                 " << g_value_size;
+    if (g_value_size_max > g_value_size) {
+      std::cerr << "-" << g_value_size_max << " (uniform)";
+    }
+    std::cerr << std::endl
+         << "  fields:                     " << g_fields
+         << " (read " << (g_read_all_fields ? "all" : "one")
+         << ", write " << (g_write_all_fields ? "all" : "one") << ")" << std::endl;
 
     if (g_read_txn_type == ReadTransactionType::Sequential) {
       std::cerr << "  read transaction type:      sequential" << std::endl;
@@ -230,16 +331,18 @@ void ycsb_parse_options(int argc, char **argv) {
       abort();
     }
 
-    if (g_zipfian_rng) {
+    if (g_key_distribution == KeyDistribution::Zipfian ||
+        g_key_distribution == KeyDistribution::ScrambledZipfian ||
+        g_key_distribution == KeyDistribution::Latest) {
       std::cerr << "  zipfian theta:              " << g_zipfian_theta << std::endl;
+    } else if (g_key_distribution == KeyDistribution::Hotspot) {
+      std::cerr << "  hot set:                    " << g_hotspot_fraction << " of keys, "
+                << g_hotspot_probability << " of accesses" << std::endl;
     }
     if (ycsb_workload.scan_percent() > 0) {
-      if (g_scan_max_length < g_scan_min_length || g_scan_min_length < 1) {
-         std::cerr << "  invalid scan range:      " << std::endl;
-         std::cerr << "  min :                    " << g_scan_min_length << std::endl;
-         std::cerr << "  max :                    " << g_scan_max_length << std::endl;
-      }
-      std::cerr << "  scan maximal range:         " << g_scan_max_length << std::endl;
+      std::cerr << "  scan range:                 [" << g_scan_min_length << ", "
+                << g_scan_max_length << "] " << (g_scan_length_zipfain_rng ? "zipfian" : "uniform")
+                << std::endl;
     }
   }
 }
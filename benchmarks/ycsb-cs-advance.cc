@@ -37,34 +37,51 @@ public:
     }
     ALWAYS_ASSERT(is_worker);
     workload = get_workload();
-    txn_counts.resize(workload.size());
+    init_txn_stats(workload.size());
+    init_sequential_txns();
 
-    const size_t batch_size = ermia::config::coro_batch_size;
-    std::vector<task<rc_t>> task_queue(batch_size);
-    std::vector<uint32_t> task_workload_idxs(batch_size);
+    std::vector<task<rc_t>> task_queue(ermia::config::coro_batch_size);
+    std::vector<uint32_t> task_workload_idxs(ermia::config::coro_batch_size);
+    // Nested frames of each slot's transaction are bump-allocated here
+    std::vector<ermia::coro::chain_arena> frame_arenas(ermia::config::coro_batch_size);
+    std::vector<uint64_t> intended_us(ermia::config::coro_batch_size);
 
     barrier_a->count_down();
     barrier_b->wait_for();
+    batch_tuner.start();
 
     while (running) {
+      // Open-loop runs wait for one arrival, then batch whatever else is due
+      txn_request req;
+      if (!next_request(true, req)) {
+        break;
+      }
       ermia::epoch_num begin_epoch = ermia::MM::epoch_enter();
       arena->reset();
+      const uint32_t max_batch_size = batch_tuner.size();
+      uint32_t batch_size = 0;
       util::timer t;
 
-      for(uint32_t i = 0; i < batch_size; i++) {
+      do {
+        uint32_t i = batch_size;
         task<rc_t> & coro_task = task_queue[i];
         ASSERT(!coro_task.valid());
-        uint32_t workload_idx = fetch_workload();
-
-        task_workload_idxs[i] = workload_idx;
-
-        ASSERT(workload[workload_idx].task_fn);
-        coro_task = workload[workload_idx].task_fn(this, i, begin_epoch);
-        coro_task.start();
+        task_workload_idxs[i] = req.workload_idx;
+        intended_us[i] = req.intended_us;
+
+        ASSERT(workload[req.workload_idx].task_fn);
+        coro_task = workload[req.workload_idx].task_fn(this, i, begin_epoch);
+        coro_task.start(&frame_arenas[i]);
+        leave_slot(i);
+      } while (++batch_size < max_batch_size && next_request(false, req));
+
+      uint32_t short_todo = 0;
+      for (uint32_t i = 0; i < batch_size; i++) {
+        short_todo += (workload[task_workload_idxs[i]].cls == kTxnShort);
       }
 
       bool batch_completed = false;
-      while (!batch_completed) {
+      for (uint32_t round = 0; !batch_completed; ++round) {
         batch_completed = true;
         for(uint32_t i = 0; i < batch_size; i++) {
           task<rc_t> & coro_task = task_queue[i];
@@ -73,19 +90,33 @@ public:
           }
 
           if (!coro_task.done()) {
-            coro_task.resume();
+            if (should_resume(task_workload_idxs[i], round, short_todo)) {
+              enter_slot(i);
+              do {
+                coro_task.resume();
+              } while (sequential_txns[task_workload_idxs[i]] && !coro_task.done());
+              leave_slot(i);
+            }
             batch_completed = false;
           } else {
-            finish_workload(coro_task.get_return_value(), task_workload_idxs[i], t);
+            short_todo -= (workload[task_workload_idxs[i]].cls == kTxnShort);
+            finish_workload(coro_task.get_return_value(), task_workload_idxs[i],
+                            latency_start(intended_us[i], t));
             coro_task = task<rc_t>(nullptr);
+            frame_arenas[i].reset();
           }
         }
       }
 
       ermia::MM::epoch_exit(0, begin_epoch);
+      batch_tuner.update(batch_size);
     }
   }
 
+  virtual const char *execution_mode() const override {
+    return g_read_txn_type == ReadTransactionType::AdvCoro ? "nested-coroutine" : "sequential";
+  }
+
   virtual workload_desc_vec get_workload() const override {
     workload_desc_vec w;
 
@@ -108,11 +139,11 @@ public:
         if (ermia::config::scan_with_it) {
           w.push_back(workload_desc("ScanWithIterator",
                                     double(ycsb_workload.scan_percent()) / 100.0,
-                                    nullptr, nullptr, TxnScanWithIterator));
+                                    nullptr, nullptr, TxnScanWithIterator).long_running());
         } else {
           LOG_IF(FATAL, ermia::config::index_probe_only) << "Not supported";
           w.push_back(workload_desc("Scan", double(ycsb_workload.scan_percent()) / 100.0,
-                                    nullptr, nullptr, TxnScan));
+                                    nullptr, nullptr, TxnScan).long_running());
         }
       } else {
         LOG(FATAL) << "Scan txn type must be adv-coro";
@@ -151,9 +182,8 @@ private:
 
     for (int j = 0; j < g_reps_per_tx; ++j) {
       ermia::varstr &k = GenerateKey(txn);
-      ermia::varstr &v = str(sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(g_value_size_max);
 
-      // TODO(tzwang): add read/write_all_fields knobs
       rc_t rc = rc_t{RC_INVALID};
       if (!ermia::config::index_probe_only) {
         AWAIT table_index->GetRecord(txn, rc, k, v);  // Read
@@ -172,7 +202,7 @@ private:
 #endif
 
       if (!ermia::config::index_probe_only) {
-        memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), sizeof(ycsb_kv::value));
+        ReadFields((char *)&v + sizeof(ermia::varstr), v, rng_gen_read_field());
         ALWAYS_ASSERT(*(char*)v.data() == 'a');
       }
     }
@@ -194,7 +224,7 @@ private:
       rc_t rc = rc_t{RC_INVALID};
       ScanRange range = GenerateScanRange(txn);
 
-      ycsb_scan_callback callback;
+      ycsb_scan_callback callback(rng_gen_read_field());
       rc = co_await table_index->Scan(txn, range.start_key, &range.end_key, callback);
 
       ALWAYS_ASSERT(callback.size() <= g_scan_max_length);
@@ -218,7 +248,7 @@ private:
     for (uint i = 0; i < g_reps_per_tx; ++i) {
       rc_t rc = rc_t{RC_INVALID};
       ScanRange range = GenerateScanRange(txn);
-      ycsb_scan_callback callback;
+      ycsb_scan_callback callback(rng_gen_read_field());
       ermia::varstr valptr;
       ermia::dbtuple* tuple = nullptr;
       auto iter = co_await ermia::ConcurrentMasstree::ScanIterator<
@@ -249,6 +279,9 @@ private:
 #endif
         }
         more = co_await iter.init_or_next</*IsNext=*/true>();
+        if (more && iter.crossed_leaf()) {
+          co_await std::experimental::suspend_always{};
+        }
       }
 
       ALWAYS_ASSERT(callback.size() <= g_scan_max_length);
@@ -277,7 +310,7 @@ private:
       values.clear();
       txn = db->NewTransaction(ermia::transaction::TXN_FLAG_READ_ONLY, *arena, txn_buf());
       for (uint i = 0; i < g_reps_per_tx; ++i) {
-        values.push_back(&str(sizeof(ycsb_kv::value)));
+        values.push_back(&str(g_value_size_max));
       }
     }
 
@@ -289,10 +322,10 @@ private:
     table_index->adv_coro_MultiGet(txn, keys, values, index_probe_tasks, get_record_tasks);
 
     if (!ermia::config::index_probe_only) {
-      ermia::varstr &v = str(sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(g_value_size_max);
       for (uint i = 0; i < g_reps_per_tx; ++i) {
         ALWAYS_ASSERT(*(char*)values[i]->data() == 'a');
-        memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)values[i]->data(), sizeof(ycsb_kv::value));
+        ReadFields((char *)&v + sizeof(ermia::varstr), *values[i], rng_gen_read_field());
       }
 
       TryCatch(db->Commit(txn));
@@ -25,7 +25,7 @@ public:
     // No replication support
     ALWAYS_ASSERT(is_worker);
     workload = get_workload();
-    txn_counts.resize(workload.size());
+    init_txn_stats(workload.size());
 
     if (ermia::config::coro_batch_schedule) {
       //PipelineScheduler();
@@ -35,6 +35,8 @@ public:
     }
   }
 
+  virtual const char *execution_mode() const override { return "2-level-coroutine"; }
+
   virtual workload_desc_vec get_workload() const override {
     workload_desc_vec w;
 
@@ -56,10 +58,10 @@ public:
     if (ycsb_workload.scan_percent()) {
       if (ermia::config::scan_with_it) {
         w.push_back(workload_desc("ScanWithIterator", double(ycsb_workload.scan_percent()) / 100.0,
-                    nullptr, TxnScanWithIterator));
+                    nullptr, TxnScanWithIterator).long_running());
       } else {
         LOG_IF(FATAL, ermia::config::index_probe_only) << "Not supported";
-        w.push_back(workload_desc("Scan", double(ycsb_workload.scan_percent()) / 100.0, nullptr, TxnScan));
+        w.push_back(workload_desc("Scan", double(ycsb_workload.scan_percent()) / 100.0, nullptr, TxnScan).long_running());
       }
     }
     return w;
@@ -97,12 +99,12 @@ public:
     }
 
     for (int i = 0; i < g_reps_per_tx; ++i) {
-      ermia::varstr &v = str(arenas[idx], sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(arenas[idx], g_value_size_max);
       rc_t rc = rc_t{RC_INVALID};
 
       if (ermia::config::index_probe_only) {
-        ermia::varstr &k = str(arenas[idx], sizeof(ycsb_kv::key));
-        new (&k) ermia::varstr((char *)&k + sizeof(ermia::varstr), sizeof(ycsb_kv::key));
+        ermia::varstr &k = str(arenas[idx], g_key_size);
+        new (&k) ermia::varstr((char *)&k + sizeof(ermia::varstr), g_key_size);
         BuildKey(rng_gen_key(), k);
 
         ermia::ConcurrentMasstree::threadinfo ti(begin_epoch);
@@ -121,7 +123,7 @@ public:
       ASSERT(ermia::config::index_probe_only || *(char*)v.data() == 'a');
 #endif
       if (!ermia::config::index_probe_only)
-        memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), sizeof(ycsb_kv::value));
+        ReadFields((char *)&v + sizeof(ermia::varstr), v, rng_gen_read_field());
     }
 
 #ifndef CORO_BATCH_COMMIT
@@ -140,7 +142,7 @@ public:
 
     for (int i = 0; i < g_reps_per_tx; ++i) {
       ermia::varstr &k = GenerateKey(txn);
-      ermia::varstr &v = str(arenas[idx], sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(arenas[idx], g_value_size_max);
       rc_t rc = rc_t{RC_INVALID};
 
       rc = co_await table_index->coro_GetRecord(txn, k, v);
@@ -154,14 +156,10 @@ public:
       ASSERT(*(char*)v.data() == 'a');
 #endif
 
-      ASSERT(v.size() == sizeof(ycsb_kv::value));
-      memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), v.size());
-
-      // Re-initialize the value structure to use my own allocated memory -
-      // DoTupleRead will change v.p to the object's data area to avoid memory
-      // copy (in the read op we just did).
-      new (&v) ermia::varstr((char *)&v + sizeof(ermia::varstr), sizeof(ycsb_kv::value));
-      new (v.data()) ycsb_kv::value("a");
+      // Build the new version in my own allocated memory - DoTupleRead
+      // changed v.p to the object's data area to avoid memory copy (in the
+      // read op we just did).
+      PrepareUpdate(v);
       rc = co_await table_index->coro_UpdateRecord(txn, k, v);  // Modify-write
 
       TryCatchCoro(rc);
@@ -169,7 +167,7 @@ public:
 
     for (int i = 0; i < g_rmw_additional_reads; ++i) {
       ermia::varstr &k = GenerateKey(txn);
-      ermia::varstr &v = str(arenas[idx], sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(arenas[idx], g_value_size_max);
       rc_t rc = rc_t{RC_INVALID};
 
       rc = co_await table_index->coro_GetRecord(txn, k, v);
@@ -182,8 +180,7 @@ public:
       ASSERT(*(char*)v.data() == 'a');
 #endif
 
-      ASSERT(v.size() == sizeof(ycsb_kv::value));
-      memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), v.size());
+      ReadFields((char *)&v + sizeof(ermia::varstr), v, rng_gen_read_field());
     }
 #ifndef CORO_BATCH_COMMIT
     TryCatchCoro(db->Commit(txn));
@@ -200,7 +197,7 @@ public:
     for (int i = 0; i < g_reps_per_tx; ++i) {
       rc_t rc = rc_t{RC_INVALID};
       ScanRange range = GenerateScanRange(txn);
-      ycsb_scan_callback callback;
+      ycsb_scan_callback callback(rng_gen_read_field());
       rc = co_await table_index->coro_Scan(txn, range.start_key, &range.end_key, callback);
 
       ALWAYS_ASSERT(callback.size() <= g_scan_max_length);
@@ -225,7 +222,7 @@ public:
     for (int i = 0; i < g_reps_per_tx; ++i) {
       rc_t rc = rc_t{RC_INVALID};
       ScanRange range = GenerateScanRange(txn);
-      ycsb_scan_callback callback;
+      ycsb_scan_callback callback(rng_gen_read_field());
       ermia::ConcurrentMasstree::coro_ScanIterator</*IsRerverse=*/false>
           iter(txn->GetXIDContext(), &table_index->GetMasstree(), range.start_key, &range.end_key);
       bool more = co_await iter.init();
@@ -249,6 +246,9 @@ public:
 #endif
         }
         more = iter.next();
+        if (more && iter.crossed_leaf()) {
+          co_await std::experimental::suspend_always{};
+        }
       }
       ALWAYS_ASSERT(callback.size() <= g_scan_max_length);
     }
@@ -21,16 +21,20 @@ class ycsb_sequential_worker : public ycsb_base_worker {
 
   virtual workload_desc_vec get_workload() const {
     workload_desc_vec w;
+    // Sequential workers in a --coro_workers run do the plain version of
+    // what the coroutine workers do
+    const ReadTransactionType read_txn_type =
+      g_read_txn_type == ReadTransactionType::SimpleCoro ? ReadTransactionType::Sequential : g_read_txn_type;
     if (ycsb_workload.insert_percent() || ycsb_workload.update_percent()) {
       LOG(FATAL) << "Not implemented";
     }
 
     if (ycsb_workload.read_percent()) {
-      if (g_read_txn_type == ReadTransactionType::AMACMultiGet) {
+      if (read_txn_type == ReadTransactionType::AMACMultiGet) {
         w.push_back(workload_desc("Read", double(ycsb_workload.read_percent()) / 100.0, TxnReadAMACMultiGet));
-      } else if (g_read_txn_type == ReadTransactionType::SimpleCoroMultiGet) {
+      } else if (read_txn_type == ReadTransactionType::SimpleCoroMultiGet) {
         w.push_back(workload_desc("Read", double(ycsb_workload.read_percent()) / 100.0, TxnReadSimpleCoroMultiGet));
-      } else if (g_read_txn_type == ReadTransactionType::Sequential) {
+      } else if (read_txn_type == ReadTransactionType::Sequential) {
         w.push_back(workload_desc("Read", double(ycsb_workload.read_percent()) / 100.0, TxnRead));
       } else {
         LOG(FATAL) << "Wrong read txn type. Supported: sequential, multiget-simple-coro, multiget-adv-coro";
@@ -39,17 +43,23 @@ class ycsb_sequential_worker : public ycsb_base_worker {
 
     if (ycsb_workload.rmw_percent()) {
       LOG_IF(FATAL, ermia::config::index_probe_only) << "Not supported";
-      LOG_IF(FATAL, g_read_txn_type != ReadTransactionType::Sequential) << "RMW txn type must be sequential";
+      LOG_IF(FATAL, read_txn_type != ReadTransactionType::Sequential) << "RMW txn type must be sequential";
       w.push_back(workload_desc("RMW", double(ycsb_workload.rmw_percent()) / 100.0, TxnRMW));
     }
 
     if (ycsb_workload.scan_percent()) {
-      LOG_IF(FATAL, g_read_txn_type != ReadTransactionType::Sequential) << "Scan txn type must be sequential";
-      if (ermia::config::scan_with_it) {
-        w.push_back(workload_desc("ScanWithIterator", double(ycsb_workload.scan_percent()) / 100.0, TxnScanWithIterator));
+      LOG_IF(FATAL, read_txn_type != ReadTransactionType::Sequential &&
+                    read_txn_type != ReadTransactionType::SimpleCoroMultiGet)
+        << "Scan txn type must be sequential or multiget-simple-coro";
+      if (read_txn_type == ReadTransactionType::SimpleCoroMultiGet) {
+        LOG_IF(FATAL, ermia::config::index_probe_only || ermia::config::scan_with_it) << "Not supported";
+        w.push_back(workload_desc("MultiScan", double(ycsb_workload.scan_percent()) / 100.0,
+                                  TxnSimpleCoroMultiScan).long_running());
+      } else if (ermia::config::scan_with_it) {
+        w.push_back(workload_desc("ScanWithIterator", double(ycsb_workload.scan_percent()) / 100.0, TxnScanWithIterator).long_running());
       } else {
         LOG_IF(FATAL, ermia::config::index_probe_only) << "Not supported";
-        w.push_back(workload_desc("Scan", double(ycsb_workload.scan_percent()) / 100.0, TxnScan));
+        w.push_back(workload_desc("Scan", double(ycsb_workload.scan_percent()) / 100.0, TxnScan).long_running());
       }
     }
 
@@ -62,6 +72,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
   static rc_t TxnRMW(bench_worker *w) { return static_cast<ycsb_sequential_worker *>(w)->txn_rmw(); }
   static rc_t TxnScan(bench_worker *w) { return static_cast<ycsb_sequential_worker *>(w)->txn_scan(); }
   static rc_t TxnScanWithIterator(bench_worker *w) { return static_cast<ycsb_sequential_worker *>(w)->txn_scan_with_iterator(); }
+  static rc_t TxnSimpleCoroMultiScan(bench_worker *w) { return static_cast<ycsb_sequential_worker *>(w)->txn_simple_coro_multiscan(); }
 
   // Read transaction using traditional sequential execution
   rc_t txn_read() {
@@ -75,8 +86,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
 
     for (uint i = 0; i < g_reps_per_tx; ++i) {
       auto &k = GenerateKey(txn);
-      ermia::varstr &v = str((ermia::config::index_probe_only) ? 0 : sizeof(ycsb_kv::value));
-      // TODO(tzwang): add read/write_all_fields knobs
+      ermia::varstr &v = str((ermia::config::index_probe_only) ? 0 : g_value_size_max);
       rc_t rc = rc_t{RC_INVALID};
       table_index->GetRecord(txn, rc, k, v);  // Read
 
@@ -88,7 +98,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
       ASSERT(ermia::config::index_probe_only || *(char*)v.data() == 'a');
 #endif
       if (!ermia::config::index_probe_only) {
-        memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), sizeof(ycsb_kv::value));
+        ReadFields((char *)&v + sizeof(ermia::varstr), v, rng_gen_read_field());
       }
     }
     if (!ermia::config::index_probe_only) {
@@ -106,7 +116,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
       values.clear();
       txn = db->NewTransaction(ermia::transaction::TXN_FLAG_READ_ONLY, *arena, txn_buf());
       for (uint i = 0; i < g_reps_per_tx; ++i) {
-        values.push_back(&str(sizeof(ycsb_kv::value)));
+        values.push_back(&str(g_value_size_max));
       }
     }
 
@@ -122,10 +132,10 @@ class ycsb_sequential_worker : public ycsb_base_worker {
     table_index->amac_MultiGet(txn, as, values);
 
     if (!ermia::config::index_probe_only) {
-      ermia::varstr &v = str(sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(g_value_size_max);
       for (uint i = 0; i < g_reps_per_tx; ++i) {
         ALWAYS_ASSERT(*(char*)values[i]->data() == 'a');
-        memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)values[i]->data(), sizeof(ycsb_kv::value));
+        ReadFields((char *)&v + sizeof(ermia::varstr), *values[i], rng_gen_read_field());
       }
 
       TryCatch(db->Commit(txn));
@@ -142,7 +152,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
       values.clear();
       txn = db->NewTransaction(ermia::transaction::TXN_FLAG_READ_ONLY, *arena, txn_buf());
       for (uint i = 0; i < g_reps_per_tx; ++i) {
-        values.push_back(&str(sizeof(ycsb_kv::value)));
+        values.push_back(&str(g_value_size_max));
       }
     }
 
@@ -156,10 +166,10 @@ class ycsb_sequential_worker : public ycsb_base_worker {
     table_index->simple_coro_MultiGet(txn, keys, values, handles);
 
     if (!ermia::config::index_probe_only) {
-      ermia::varstr &v = str(sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(g_value_size_max);
       for (uint i = 0; i< g_reps_per_tx; ++i) {
         ALWAYS_ASSERT(*(char*)values[i]->data() == 'a');
-        memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)values[i]->data(), sizeof(ycsb_kv::value));
+        ReadFields((char *)&v + sizeof(ermia::varstr), *values[i], rng_gen_read_field());
       }
 
       TryCatch(db->Commit(txn));
@@ -172,8 +182,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
     ermia::transaction *txn = db->NewTransaction(0, *arena, txn_buf());
     for (uint i = 0; i < g_reps_per_tx; ++i) {
       ermia::varstr &k = GenerateKey(txn);
-      ermia::varstr &v = str(sizeof(ycsb_kv::value));
-      // TODO(tzwang): add read/write_all_fields knobs
+      ermia::varstr &v = str(g_value_size_max);
       rc_t rc = rc_t{RC_INVALID};
       table_index->GetRecord(txn, rc, k, v);  // Read
 
@@ -186,22 +195,17 @@ class ycsb_sequential_worker : public ycsb_base_worker {
       ASSERT(*(char*)v.data() == 'a');
 #endif
 
-      ASSERT(v.size() == sizeof(ycsb_kv::value));
-      memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), v.size());
-
-      // Re-initialize the value structure to use my own allocated memory -
-      // DoTupleRead will change v.p to the object's data area to avoid memory
-      // copy (in the read op we just did).
-      new (&v) ermia::varstr((char *)&v + sizeof(ermia::varstr), sizeof(ycsb_kv::value));
-      new (v.data()) ycsb_kv::value("a");
+      // Build the new version in my own allocated memory - DoTupleRead
+      // changed v.p to the object's data area to avoid memory copy (in the
+      // read op we just did).
+      PrepareUpdate(v);
       TryCatch(table_index->UpdateRecord(txn, k, v));  // Modify-write
     }
 
     for (uint i = 0; i < g_rmw_additional_reads; ++i) {
       ermia::varstr &k = GenerateKey(txn);
-      ermia::varstr &v = str(sizeof(ycsb_kv::value));
+      ermia::varstr &v = str(g_value_size_max);
 
-      // TODO(tzwang): add read/write_all_fields knobs
       rc_t rc = rc_t{RC_INVALID};
       table_index->GetRecord(txn, rc, k, v);  // Read
 
@@ -213,8 +217,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
       ASSERT(*(char*)v.data() == 'a');
 #endif
 
-      ASSERT(v.size() == sizeof(ycsb_kv::value));
-      memcpy((char*)(&v) + sizeof(ermia::varstr), (char *)v.data(), v.size());
+      ReadFields((char *)&v + sizeof(ermia::varstr), v, rng_gen_read_field());
     }
     TryCatch(db->Commit(txn));
     return {RC_TRUE};
@@ -225,7 +228,7 @@ class ycsb_sequential_worker : public ycsb_base_worker {
     for (uint i = 0; i < g_reps_per_tx; ++i) {
       rc_t rc = rc_t{RC_INVALID};
       ScanRange range = GenerateScanRange(txn);
-      ycsb_scan_callback callback;
+      ycsb_scan_callback callback(rng_gen_read_field());
       rc = table_index->Scan(txn, range.start_key, &range.end_key, callback);
 
       ALWAYS_ASSERT(callback.size() <= g_scan_max_length);
@@ -239,12 +242,38 @@ class ycsb_sequential_worker : public ycsb_base_worker {
     return {RC_TRUE};
   }
 
+  // Scans all g_reps_per_tx ranges at once using simple coroutines
+  rc_t txn_simple_coro_multiscan() {
+    ermia::transaction *txn = db->NewTransaction(ermia::transaction::TXN_FLAG_READ_ONLY, *arena, txn_buf());
+    scan_ranges.clear();
+    scan_callbacks.resize(g_reps_per_tx);
+    for (uint i = 0; i < g_reps_per_tx; ++i) {
+      ScanRange range = GenerateScanRange(txn);
+      scan_callbacks[i] = ycsb_scan_callback(rng_gen_read_field());
+      scan_ranges.emplace_back(&range.start_key, &range.end_key, &scan_callbacks[i]);
+    }
+
+    thread_local std::vector<std::experimental::coroutine_handle<ermia::coro::generator<rc_t>::promise_type>> handles;
+    table_index->simple_coro_MultiScan(txn, scan_ranges, rcs, handles);
+
+    for (uint i = 0; i < g_reps_per_tx; ++i) {
+      ALWAYS_ASSERT(scan_callbacks[i].size() <= g_scan_max_length);
+#if defined(SSI) || defined(SSN) || defined(MVOCC)
+      TryCatch(rcs[i]);  // Might abort if we use SSI/SSN/MVOCC
+#else
+      ALWAYS_ASSERT(rcs[i]._val == RC_TRUE);
+#endif
+    }
+    TryCatch(db->Commit(txn));
+    return {RC_TRUE};
+  }
+
   rc_t txn_scan_with_iterator() {
     ermia::transaction *txn = db->NewTransaction(ermia::transaction::TXN_FLAG_READ_ONLY, *arena, txn_buf());
     for (uint i = 0; i < g_reps_per_tx; ++i) {
       rc_t rc = rc_t{RC_INVALID};
       ScanRange range = GenerateScanRange(txn);
-      ycsb_scan_callback callback;
+      ycsb_scan_callback callback(rng_gen_read_field());
       ermia::varstr valptr;
       ermia::dbtuple* tuple = nullptr;
       auto iter = ermia::ConcurrentMasstree::ScanIterator<
@@ -286,8 +315,17 @@ class ycsb_sequential_worker : public ycsb_base_worker {
   std::vector<ermia::ConcurrentMasstree::AMACState> as;
   std::vector<ermia::varstr *> keys;
   std::vector<ermia::varstr *> values;
+  std::vector<ermia::ConcurrentMasstreeIndex::ScanRange> scan_ranges;
+  std::vector<ycsb_scan_callback> scan_callbacks;
+  std::vector<rc_t> rcs;
 };
 
+bench_worker *ycsb_new_sequential_worker(unsigned int worker_id, unsigned long seed, ermia::Engine *db,
+                                         const std::map<std::string, ermia::OrderedIndex *> &open_tables,
+                                         spin_barrier *barrier_a, spin_barrier *barrier_b) {
+  return new ycsb_sequential_worker(worker_id, seed, db, open_tables, barrier_a, barrier_b);
+}
+
 void ycsb_do_test(ermia::Engine *db, int argc, char **argv) {
   ycsb_parse_options(argc, argv);
   ycsb_bench_runner<ycsb_sequential_worker> r(db);
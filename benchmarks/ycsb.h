@@ -11,13 +11,36 @@
 #include "../macros.h"
 
 extern uint g_initial_table_size;
-extern int g_zipfian_rng;
 extern double g_zipfian_theta;
-extern const int g_scan_min_length;
+extern double g_hotspot_fraction;
+extern double g_hotspot_probability;
+extern int g_scan_min_length;
 extern int g_scan_max_length;
 extern int g_scan_length_zipfain_rng;
 extern double g_scan_length_zipfain_theta;
 
+// How keys are picked, see --distribution
+enum class KeyDistribution {
+  Uniform,
+  Zipfian,           // hottest keys are the smallest ones, contiguous in the index
+  ScrambledZipfian,  // zipfian ranks hashed over the key space
+  Latest,            // zipfian, hottest keys are the largest (newest) ones
+  Hotspot,           // g_hotspot_probability of accesses to the first g_hotspot_fraction of keys
+  Sequential,        // each worker walks the key space from its own offset
+};
+extern KeyDistribution g_key_distribution;
+
+// FNV-1a over the bytes of [v], as YCSB scrambles zipfian ranks
+inline uint64_t FnvHash64(uint64_t v) {
+  uint64_t h = 0xCBF29CE484222325ull;
+  for (int i = 0; i < 8; ++i) {
+    h ^= v & 0xff;
+    h *= 0x100000001B3ull;
+    v >>= 8;
+  }
+  return h;
+}
+
 enum class ReadTransactionType {
   Sequential,
   AMACMultiGet,
@@ -27,22 +50,52 @@ enum class ReadTransactionType {
   AdvCoro
 };
 
-// TODO(tzwang); support other value length specified by user
-#define YCSB_KEY_FIELDS(x, y) x(inline_str_fixed<8>, y_key)
-#define YCSB_VALUE_FIELDS(x, y) x(inline_str_fixed<8>, y_value)
-DO_STRUCT(ycsb_kv, YCSB_KEY_FIELDS, YCSB_VALUE_FIELDS);
+// Record shape, see --key-size, --value-size, --value-size-max and --fields.
+// Keys are a repeated "corobase" prefix followed by the big-endian record
+// number. A value of n bytes is split into g_fields fields of n / g_fields
+// bytes, the last one also taking the remainder.
+extern uint g_key_size;
+extern uint g_value_size;
+extern uint g_value_size_max;
+extern uint g_fields;
+extern int g_read_all_fields;
+extern int g_write_all_fields;
+
+static const uint32_t kYcsbAllFields = ~uint32_t{0};
 
 inline void BuildKey(uint64_t key, ermia::varstr &k) {
-  ASSERT (sizeof(ycsb_kv::key) % sizeof(uint64_t) == 0);
-  static const char *prefix = "corobase";
-  ycsb_kv::key extended_key;
-  for (uint offset = 0; offset < sizeof(ycsb_kv::key); offset = offset + sizeof(uint64_t)) {
-    if (offset + sizeof(uint64_t) < sizeof(ycsb_kv::key))
-      memcpy((void *)(extended_key.y_key.data() + offset), (void *)prefix, sizeof(uint64_t));
-    else
-      *(uint64_t *)(extended_key.y_key.data() + offset) = __builtin_bswap64(key);
+  static const char prefix[] = "corobase";
+  ASSERT(k.size() == g_key_size);
+  char *p = (char *)k.data();
+  const uint32_t prefix_len = g_key_size - sizeof(uint64_t);
+  for (uint32_t i = 0; i < prefix_len; ++i) {
+    p[i] = prefix[i % (sizeof(prefix) - 1)];
+  }
+  *(uint64_t *)(p + prefix_len) = __builtin_bswap64(key);
+}
+
+// Byte range [begin, end) of [field] in a value of [size] bytes
+inline std::pair<uint32_t, uint32_t> FieldRange(uint32_t size, uint32_t field) {
+  if (field == kYcsbAllFields) {
+    return {0, size};
   }
-  Encode(k, extended_key);
+  ASSERT(field < g_fields);
+  const uint32_t width = size / g_fields;
+  return {field * width, field == g_fields - 1 ? size : (field + 1) * width};
+}
+
+// Copy [field] (or all fields) of the record in [v] out to [dst], which is
+// what a YCSB client does with what it reads
+inline void ReadFields(char *dst, const ermia::varstr &v, uint32_t field) {
+  auto range = FieldRange(v.size(), field);
+  memcpy(dst + range.first, v.data() + range.first, range.second - range.first);
+}
+
+// Overwrite [field] (or all fields) of [v], keeping the leading 'a' readers
+// check for
+inline void WriteFields(ermia::varstr &v, uint32_t field) {
+  auto range = FieldRange(v.size(), field);
+  memset(v.data() + range.first, 'a', range.second - range.first);
 }
 
 struct YcsbWorkload {
@@ -103,6 +156,13 @@ class ycsb_usertable_loader : public bench_loader {
 void ycsb_create_db(ermia::Engine *db);
 void ycsb_parse_options(int argc, char **argv);
 
+#ifndef ADV_COROUTINE
+// Defined in ycsb.cc, for runs that mix coroutine and sequential workers
+bench_worker *ycsb_new_sequential_worker(unsigned int worker_id, unsigned long seed, ermia::Engine *db,
+                                         const std::map<std::string, ermia::OrderedIndex *> &open_tables,
+                                         spin_barrier *barrier_a, spin_barrier *barrier_b);
+#endif
+
 template<class WorkerType>
 class ycsb_bench_runner : public bench_runner {
  public:
@@ -147,6 +207,13 @@ class ycsb_bench_runner : public bench_runner {
     for (size_t i = 0; i < ermia::config::worker_threads; i++) {
       auto seed = r.next();
       LOG(INFO) << "RND SEED: " << seed;
+#ifndef ADV_COROUTINE
+      // Workers beyond --coro_workers run the sequential version
+      if (ermia::config::coro_tx && i >= ermia::config::coro_workers) {
+        ret.push_back(ycsb_new_sequential_worker(i, seed, db, open_tables, &barrier_a, &barrier_b));
+        continue;
+      }
+#endif
       ret.push_back(new WorkerType(i, seed, db, open_tables, &barrier_a, &barrier_b));
     }
     return ret;
@@ -162,15 +229,20 @@ class ycsb_base_worker : public bench_worker {
         table_index((ermia::ConcurrentMasstreeIndex*)open_tables.at("USERTABLE")) {
       const unsigned int key_rng_seed = 1237 + worker_id;
       uniform_rng = foedus::assorted::UniformRandom(key_rng_seed);
-      if (g_zipfian_rng) {
+      if (g_key_distribution == KeyDistribution::Zipfian ||
+          g_key_distribution == KeyDistribution::ScrambledZipfian ||
+          g_key_distribution == KeyDistribution::Latest) {
           zipfian_rng.init(g_initial_table_size, g_zipfian_theta, key_rng_seed);
       }
+      sequential_key = uint64_t(g_initial_table_size) / ermia::config::worker_threads * worker_id;
+
+      field_rng = foedus::assorted::UniformRandom(4711 + worker_id);
 
       const unsigned int scan_length_rng_seed = 2358 + worker_id;
       scan_length_uniform_rng =
           foedus::assorted::UniformRandom(scan_length_rng_seed);
-      if (g_scan_length_zipfain_rng) {
-          scan_length_zipfian_rng.init(g_scan_max_length,
+      if (g_scan_length_zipfain_rng && g_scan_max_length > g_scan_min_length) {
+          scan_length_zipfian_rng.init(g_scan_max_length - g_scan_min_length + 1,
                                        g_scan_length_zipfain_theta,
                                        scan_length_rng_seed);
       }
@@ -193,29 +265,68 @@ class ycsb_base_worker : public bench_worker {
   ALWAYS_INLINE ermia::varstr &str(ermia::str_arena &a, uint64_t size) { return *a.next(size); }
 
   uint64_t rng_gen_key() {
-    uint64_t r = 0;
-    if (g_zipfian_rng) {
-      r = zipfian_rng.next();
-    } else {
-      r = uniform_rng.uniform_within(0, g_initial_table_size - 1);
+    switch (g_key_distribution) {
+      case KeyDistribution::Zipfian:
+        return zipfian_rng.next();
+      case KeyDistribution::ScrambledZipfian:
+        return FnvHash64(zipfian_rng.next()) % g_initial_table_size;
+      case KeyDistribution::Latest:
+        return g_initial_table_size - 1 - zipfian_rng.next();
+      case KeyDistribution::Hotspot: {
+        const uint32_t hot_keys = std::max<uint32_t>(1, g_initial_table_size * g_hotspot_fraction);
+        if (hot_keys >= g_initial_table_size ||
+            uniform_rng.uniform_within(0, 9999) < g_hotspot_probability * 10000) {
+          return uniform_rng.uniform_within(0, hot_keys - 1);
+        }
+        return uniform_rng.uniform_within(hot_keys, g_initial_table_size - 1);
+      }
+      case KeyDistribution::Sequential: {
+        uint64_t r = sequential_key;
+        if (++sequential_key == g_initial_table_size) {
+          sequential_key = 0;
+        }
+        return r;
+      }
+      case KeyDistribution::Uniform:
+      default:
+        return uniform_rng.uniform_within(0, g_initial_table_size - 1);
     }
-    return r;
   }
 
+  uint32_t rng_gen_read_field() {
+    return g_read_all_fields ? kYcsbAllFields : field_rng.uniform_within(0, g_fields - 1);
+  }
+
+  uint32_t rng_gen_write_field() {
+    return g_write_all_fields ? kYcsbAllFields : field_rng.uniform_within(0, g_fields - 1);
+  }
+
+  // Turn [v], just read from the table into arena space sized for the largest
+  // record, into the new version to write: only a field update needs the old
+  // contents copied over first.
+  void PrepareUpdate(ermia::varstr &v) {
+    const uint32_t size = v.size();
+    const uint32_t field = rng_gen_write_field();
+    char *buf = (char *)&v + sizeof(ermia::varstr);
+    if (field != kYcsbAllFields) {
+      memcpy(buf, v.data(), size);
+    }
+    new (&v) ermia::varstr(buf, size);
+    WriteFields(v, field);
+  }
+
+  // Scan length in [g_scan_min_length, g_scan_max_length], shortest ones
+  // the most likely under the zipfian length distribution
   uint64_t rng_gen_scan_length() {
-    uint64_t r = 0;
-    if(g_scan_length_zipfain_rng) {
-      while (!r)
-        r = scan_length_zipfian_rng.next();
-    } else {
-      r = scan_length_uniform_rng.uniform_within(g_scan_min_length, g_scan_max_length);
+    if (g_scan_length_zipfain_rng && g_scan_max_length > g_scan_min_length) {
+      return g_scan_min_length + scan_length_zipfian_rng.next();
     }
-    return r;
+    return scan_length_uniform_rng.uniform_within(g_scan_min_length, g_scan_max_length);
   }
 
   ermia::varstr &GenerateKey(ermia::transaction *t) {
-    ermia::varstr &k = t ? *t->string_allocator().next(sizeof(ycsb_kv::key)) : str(sizeof(ycsb_kv::key));
-    new (&k) ermia::varstr((char *)&k + sizeof(ermia::varstr), sizeof(ycsb_kv::key));
+    ermia::varstr &k = t ? *t->string_allocator().next(g_key_size) : str(g_key_size);
+    new (&k) ermia::varstr((char *)&k + sizeof(ermia::varstr), g_key_size);
     ::BuildKey(rng_gen_key(), k);
     return k;
   }
@@ -226,11 +337,11 @@ class ycsb_base_worker : public bench_worker {
   };
 
   ScanRange GenerateScanRange(ermia::transaction *t) {
-    ermia::varstr &start_key = t ? *t->string_allocator().next(sizeof(ycsb_kv::key)) : str(sizeof(ycsb_kv::key));
-    ermia::varstr &end_key = t ? *t->string_allocator().next(sizeof(ycsb_kv::key)) : str(sizeof(ycsb_kv::key));
+    ermia::varstr &start_key = t ? *t->string_allocator().next(g_key_size) : str(g_key_size);
+    ermia::varstr &end_key = t ? *t->string_allocator().next(g_key_size) : str(g_key_size);
 
-    new (&start_key) ermia::varstr((char *)&start_key + sizeof(ermia::varstr), sizeof(ycsb_kv::key));
-    new (&end_key) ermia::varstr((char *)&end_key + sizeof(ermia::varstr), sizeof(ycsb_kv::key));
+    new (&start_key) ermia::varstr((char *)&start_key + sizeof(ermia::varstr), g_key_size);
+    new (&end_key) ermia::varstr((char *)&end_key + sizeof(ermia::varstr), g_key_size);
     uint64_t r_start_key = rng_gen_key();
     uint64_t r_end_key = r_start_key + rng_gen_scan_length();
     ::BuildKey(r_start_key, start_key);
@@ -242,21 +353,26 @@ class ycsb_base_worker : public bench_worker {
   ermia::ConcurrentMasstreeIndex *table_index;
   foedus::assorted::UniformRandom uniform_rng;
   foedus::assorted::ZipfianRandom zipfian_rng;
+  uint64_t sequential_key;
+  foedus::assorted::UniformRandom field_rng;
   foedus::assorted::UniformRandom scan_length_uniform_rng;
   foedus::assorted::ZipfianRandom scan_length_zipfian_rng;
 };
 
 class ycsb_scan_callback : public ermia::OrderedIndex::ScanCallback {
   public:
-    ycsb_scan_callback() : n(0){}
+    explicit ycsb_scan_callback(uint32_t field = kYcsbAllFields) : n(0), field(field) {}
     bool Invoke(const char *keyp, size_t keylen, const ermia::varstr &value) override {
-      MARK_REFERENCED(keyp);
-      MARK_REFERENCED(keylen);
 #if defined(SI)
       ASSERT(*(char *)value.data() == 'a');
 #endif
-      memcpy(value_buf, value.data(), sizeof(ycsb_kv::value));
-      memcpy(key_buf, keyp, keylen);
+      // Scanned records go to a per-thread buffer sized for the largest one
+      static thread_local std::vector<char> buf;
+      if (buf.size() < g_key_size + g_value_size_max) {
+        buf.resize(g_key_size + g_value_size_max);
+      }
+      memcpy(buf.data(), keyp, keylen);
+      ReadFields(buf.data() + g_key_size, value, field);
       n++;
       return true;
     }
@@ -265,6 +381,5 @@ class ycsb_scan_callback : public ermia::OrderedIndex::ScanCallback {
 
   private:
     int32_t n;
-    unsigned char key_buf[sizeof(ycsb_kv::key)];
-    unsigned char value_buf[sizeof(ycsb_kv::value)];
+    uint32_t field;
 };
@@ -191,6 +191,18 @@ void ConcurrentMasstreeIndex::simple_coro_MultiOps(std::vector<rc_t> &rcs,
   }
 }
 
+void ConcurrentMasstreeIndex::simple_coro_MultiScan(
+    transaction *t, std::vector<ScanRange> &ranges, std::vector<rc_t> &rcs,
+    std::vector<std::experimental::coroutine_handle<ermia::coro::generator<rc_t>::promise_type>> &handles) {
+  rcs.resize(ranges.size());
+  handles.resize(ranges.size());
+  for (uint32_t i = 0; i < ranges.size(); ++i) {
+    auto &r = ranges[i];
+    handles[i] = coro_Scan(t, *r.start_key, r.end_key, *r.callback, r.limit).get_handle();
+  }
+  simple_coro_MultiOps(rcs, handles);
+}
+
 ermia::coro::generator<rc_t> ConcurrentMasstreeIndex::coro_GetRecordSV(transaction *t, const varstr &key,
                                                                        varstr &value, OID *out_oid) {
   OID oid = INVALID_OID;
@@ -285,6 +297,7 @@ forward:
 // start: oid_get_version
     oid_array *oa = table_descriptor->GetTupleArray();
     TXN::xid_context *visitor_xc = t->xc;
+    oa->count_access(oid);
     fat_ptr *entry = oa->get(oid);
 start_over:
     ::prefetch((const char*)entry);
@@ -401,95 +414,106 @@ ermia::coro::generator<rc_t> ConcurrentMasstreeIndex::coro_GetRecord(transaction
   ConcurrentMasstree::threadinfo ti(t->xc->begin_epoch);
   ConcurrentMasstree::unlocked_tcursor_type lp(*masstree_.get_table(), key.data(), key.size());
 
+  bool found = false;
+  BatchProbeCache *probe_cache = tls_batch_probe_cache;
+  bool probe_cached = probe_cache && probe_cache->Get(this, key, oid);
+  if (probe_cached) {
+    found = true;
+  } else {
 // start: find_unlocked
-  int match;
-  key_indexed_position kx;
-  ConcurrentMasstree::node_base_type *root = const_cast<ConcurrentMasstree::node_base_type *>(lp.root_);
+    int match;
+    key_indexed_position kx;
+    ConcurrentMasstree::node_base_type *root = const_cast<ConcurrentMasstree::node_base_type *>(lp.root_);
 
 retry:
 // start: reach_leaf
-  const ConcurrentMasstree::node_base_type* n[2];
-  ConcurrentMasstree::nodeversion_type v[2];
-  bool sense;
+    const ConcurrentMasstree::node_base_type* n[2];
+    ConcurrentMasstree::nodeversion_type v[2];
+    bool sense;
 
 // Get a non-stale root.
 // Detect staleness by checking whether n has ever split.
 // The true root has never split.
-  sense = false;
-  n[sense] = root;
-  while (1) {
-    v[sense] = n[sense]->stable_annotated(ti.stable_fence());
-    if (!v[sense].has_split()) break;
-    n[sense] = n[sense]->unsplit_ancestor();
-  }
+    sense = false;
+    n[sense] = root;
+    while (1) {
+      v[sense] = n[sense]->stable_annotated(ti.stable_fence());
+      if (!v[sense].has_split()) break;
+      n[sense] = n[sense]->unsplit_ancestor();
+    }
 
-  // Loop over internal nodes.
-  while (!v[sense].isleaf()) {
-    const ConcurrentMasstree::internode_type* in = static_cast<const ConcurrentMasstree::internode_type*>(n[sense]);
-    in->prefetch();
-    co_await std::experimental::suspend_always{};
-    int kp = ConcurrentMasstree::internode_type::bound_type::upper(lp.ka_, *in);
-    n[!sense] = in->child_[kp];
-    if (!n[!sense]) goto retry;
+    // Loop over internal nodes.
+    while (!v[sense].isleaf()) {
+      const ConcurrentMasstree::internode_type* in = static_cast<const ConcurrentMasstree::internode_type*>(n[sense]);
+      in->prefetch();
+      co_await std::experimental::suspend_always{};
+      int kp = ConcurrentMasstree::internode_type::bound_type::upper(lp.ka_, *in);
+      n[!sense] = in->child_[kp];
+      if (!n[!sense]) goto retry;
 
-    //const ConcurrentMasstree::internode_type* in2 = static_cast<const ConcurrentMasstree::internode_type*>(n[!sense]);
-    //in2->prefetch();
-    //co_await std::experimental::suspend_always{};
-    v[!sense] = n[!sense]->stable_annotated(ti.stable_fence());
+      //const ConcurrentMasstree::internode_type* in2 = static_cast<const ConcurrentMasstree::internode_type*>(n[!sense]);
+      //in2->prefetch();
+      //co_await std::experimental::suspend_always{};
+      v[!sense] = n[!sense]->stable_annotated(ti.stable_fence());
 
-    if (likely(!in->has_changed(v[sense]))) {
-      sense = !sense;
-      continue;
-    }
+      if (likely(!in->has_changed(v[sense]))) {
+        sense = !sense;
+        continue;
+      }
 
-    ConcurrentMasstree::nodeversion_type oldv = v[sense];
-    v[sense] = in->stable_annotated(ti.stable_fence());
-    if (oldv.has_split(v[sense]) &&
-        in->stable_last_key_compare(lp.ka_, v[sense], ti) > 0) {
-      goto retry;
+      ConcurrentMasstree::nodeversion_type oldv = v[sense];
+      v[sense] = in->stable_annotated(ti.stable_fence());
+      if (oldv.has_split(v[sense]) &&
+          in->stable_last_key_compare(lp.ka_, v[sense], ti) > 0) {
+        goto retry;
+      }
     }
-  }
 
-  lp.v_ = v[sense];
-  lp.n_ = const_cast<ConcurrentMasstree::leaf_type *>(static_cast<const ConcurrentMasstree::leaf_type *>(n[sense]));
+    lp.v_ = v[sense];
+    lp.n_ = const_cast<ConcurrentMasstree::leaf_type *>(static_cast<const ConcurrentMasstree::leaf_type *>(n[sense]));
 // end: reach_leaf
 
 forward:
-  if (lp.v_.deleted()) goto retry;
+    if (lp.v_.deleted()) goto retry;
 
-  // XXX(tzwang): already working on this node, no need to prefetch+yield again?
-  //lp.n_->prefetch();
-  //co_await std::experimental::suspend_always{};
-  lp.perm_ = lp.n_->permutation();
-  kx = ConcurrentMasstree::leaf_type::bound_type::lower(lp.ka_, lp);
-  if (kx.p >= 0) {
-    lp.lv_ = lp.n_->lv_[kx.p];
-    lp.lv_.prefetch(lp.n_->keylenx_[kx.p]);
-    co_await std::experimental::suspend_always{};
-    match = lp.n_->ksuf_matches(kx.p, lp.ka_);
-  } else
-    match = 0;
-  if (lp.n_->has_changed(lp.v_)) {
-    lp.n_ = lp.n_->advance_to_key(lp.ka_, lp.v_, ti);
-    goto forward;
-  }
+    // XXX(tzwang): already working on this node, no need to prefetch+yield again?
+    //lp.n_->prefetch();
+    //co_await std::experimental::suspend_always{};
+    lp.perm_ = lp.n_->permutation();
+    kx = ConcurrentMasstree::leaf_type::bound_type::lower(lp.ka_, lp);
+    if (kx.p >= 0) {
+      lp.lv_ = lp.n_->lv_[kx.p];
+      lp.lv_.prefetch(lp.n_->keylenx_[kx.p]);
+      co_await std::experimental::suspend_always{};
+      match = lp.n_->ksuf_matches(kx.p, lp.ka_);
+    } else
+      match = 0;
+    if (lp.n_->has_changed(lp.v_)) {
+      lp.n_ = lp.n_->advance_to_key(lp.ka_, lp.v_, ti);
+      goto forward;
+    }
 
-  if (match < 0) {
-    lp.ka_.shift_by(-match);
-    root = lp.lv_.layer();
-    goto retry;
-  }
+    if (match < 0) {
+      lp.ka_.shift_by(-match);
+      root = lp.lv_.layer();
+      goto retry;
+    }
 // end: find_unlocked
 
-  bool found = match;
+    found = match;
+    if (found) {
+      oid = lp.value();
+    }
+  }
+// end: masstree search
+
   dbtuple *tuple = nullptr;
   if (found) {
-    oid = lp.value();
-// end: masstree search
 
 // start: oid_get_version
     oid_array *oa = table_descriptor->GetTupleArray();
     TXN::xid_context *visitor_xc = t->xc;
+    oa->count_access(oid);
     fat_ptr *entry = oa->get(oid);
 start_over:
     ::prefetch((const char*)entry);
@@ -582,6 +606,10 @@ start_over:
         goto handle_invisible;
       }
     handle_visible:
+      // Only share keys with a committed version, those can't go away
+      if (probe_cache && !probe_cached && cur_obj->GetClsn().asi_type() == fat_ptr::ASI_LOG) {
+        probe_cache->Put(this, key, oid);
+      }
       if (out_oid) {
         *out_oid = oid;
       }
@@ -1288,7 +1316,7 @@ ermia::coro::generator<rc_t> ConcurrentMasstreeIndex::coro_Scan(transaction *t,
 
   t->ensure_active();
 
-  if (unlikely(end_key && *end_key <= start_key)) {
+  if (unlikely((end_key && *end_key <= start_key) || !max_keys)) {
     co_return c.return_code;
   }
 
@@ -1321,6 +1349,7 @@ ermia::coro::generator<rc_t> ConcurrentMasstreeIndex::coro_Scan(transaction *t,
   leafvalue_type entry = leafvalue_type::make_empty();
 
   int scancount = 0;
+  uint32_t nemitted = 0;
   int state;
   bool emit_firstkey = true;
 
@@ -1468,7 +1497,8 @@ ermia::coro::generator<rc_t> ConcurrentMasstreeIndex::coro_Scan(transaction *t,
             goto get_version_start_over;
           }
           if (visible) {
-            if (!scanner.visit_value(ka, cur_obj->GetPinnedTuple())) {
+            if (!scanner.visit_value(ka, cur_obj->GetPinnedTuple()) ||
+                ++nemitted >= max_keys) {
               goto done;
             }
             break;
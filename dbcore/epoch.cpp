@@ -1,7 +1,10 @@
 #include "epoch.h"
 
-#include <map>
+#include <numa.h>
+#include <sched.h>
+
 #include <type_traits>
+#include <vector>
 
 namespace ermia {
 
@@ -58,11 +61,15 @@ struct epoch_mgr::thread_state {
   epoch_num end;
   bool straggler;
   bool initialized;
+  uint32_t node;  // which of private_state::nodes we are in
+  uint32_t slot;  // and where
   void *cookie;
 };
 
 static_assert(std::is_pod<epoch_mgr::thread_state>::value,
               "epoch_mgr::thread_state must be POD");
+static_assert(sizeof(epoch_mgr::thread_state) <= epoch_mgr::tls_storage::SIZE,
+              "epoch_mgr::thread_state must fit in tls_storage");
 
 struct epoch_mgr::private_state {
   void *operator new(size_t sz) {
@@ -84,7 +91,13 @@ struct epoch_mgr::private_state {
   bool ready_for_safe_point = true;
 
   uint64_t nstragglers = 0;
-  std::map<pthread_t, thread_state *> threads;
+
+  /* Registered threads, grouped by the node they registered on.
+     new_epoch() walks one node's dense array at a time instead of a
+     tree of pointers, and a thread leaves in O(1) by its slot.
+   */
+  std::vector<std::vector<thread_state *>> nodes;
+  size_t nthreads = 0;
   void *cooling_cookie = 0;
   void *cold_cookie = 0;
 
@@ -154,7 +167,7 @@ bool epoch_mgr::new_epoch() {
   ASSERT(not state->cold_cookie);
 
   // for straggler tracking...
-  thread_state *stragglers[state->threads.size()];
+  thread_state *stragglers[state->nthreads];
   size_t nstragglers = 0;
 
   /* Epoch N+1 is opening.
@@ -182,28 +195,29 @@ bool epoch_mgr::new_epoch() {
      at each epoch change, we leave the epoch alone until it reaches
      cold status naturally.
    */
-  for (auto &entry : state->threads) {
-    auto *t = entry.second;
-    cookie = cb.epoch_ended_thread(cb.cookie, cookie, t->cookie);
-
-    /* Epoch N-1 is transitioning to cold status. Flag any
-       stragglers that would prevent its reclamation.
-
-       Straggler threads have active transactions that started
-       during epoch N-1. Anything older than that is due to a
-       race with thread_enter() and can be ignored (the other
-       thread is responsible to detect the race and retry).
-
-       Note that a race could cause us to flag a thread as a
-       straggler even though it has not actually finished starting
-       its transaction (and therefore cannot have accessed any
-       resources). It has no way to detect that situation,
-       however, and the only impact of the false positive is to
-       slow things down a bit.
-    */
-    auto begin = volatile_read(t->begin);
-    auto end = volatile_read(t->end);
-    if (begin == N - 1 and begin > end) stragglers[nstragglers++] = t;
+  for (auto &node : state->nodes) {
+    for (auto *t : node) {
+      cookie = cb.epoch_ended_thread(cb.cookie, cookie, t->cookie);
+
+      /* Epoch N-1 is transitioning to cold status. Flag any
+         stragglers that would prevent its reclamation.
+
+         Straggler threads have active transactions that started
+         during epoch N-1. Anything older than that is due to a
+         race with thread_enter() and can be ignored (the other
+         thread is responsible to detect the race and retry).
+
+         Note that a race could cause us to flag a thread as a
+         straggler even though it has not actually finished starting
+         its transaction (and therefore cannot have accessed any
+         resources). It has no way to detect that situation,
+         however, and the only impact of the false positive is to
+         slow things down a bit.
+      */
+      auto begin = volatile_read(t->begin);
+      auto end = volatile_read(t->end);
+      if (begin == N - 1 and begin > end) stragglers[nstragglers++] = t;
+    }
   }
 
   volatile_write(state->cold_cookie, state->cooling_cookie);
@@ -228,9 +242,8 @@ void epoch_mgr::thread_init() {
   auto *self = get_tls(this);
   DIE_IF(self->initialized, "Thread already registered");
 
-  auto tid = pthread_self();
-  ELOG("Registering thread %ld with epoch manager %p\n", (long)(uintptr_t)tid,
-       this);
+  ELOG("Registering thread %ld with epoch manager %p\n",
+       (long)(uintptr_t)pthread_self(), this);
 
   self->initialized = true;
   ASSERT(not self->begin);
@@ -250,6 +263,7 @@ void epoch_mgr::thread_init() {
     };
 
     cb.global_init(cb.cookie);
+    tmp->nodes.resize(numa_max_node() + 1);
     state = tmp;
     success = true;
 
@@ -258,8 +272,13 @@ void epoch_mgr::thread_init() {
   }
 
   // make the system aware of us
-  state->threads.insert(std::make_pair(tid, self));
-  DEFER_UNLESS(success, state->threads.erase(tid));
+  int node = numa_node_of_cpu(sched_getcpu());
+  self->node = node < 0 ? 0 : node;
+  auto &slots = state->nodes[self->node];
+  self->slot = slots.size();
+  slots.push_back(self);
+  ++state->nthreads;
+  DEFER_UNLESS(success, slots.pop_back(); --state->nthreads);
 
   self->cookie = cb.thread_registered(cb.cookie);
   XDEFER_UNLESS(success, cb.thread_deregistered(cb.cookie, self->cookie));
@@ -294,9 +313,12 @@ void epoch_mgr::thread_fini() {
   self->initialized = false;
 
   // remove us from the system
-  auto found = state->threads.erase(pthread_self());
-  ASSERT(found);
-  if (not state->threads.empty()) return;
+  auto &slots = state->nodes[self->node];
+  ASSERT(slots[self->slot] == self);
+  slots[self->slot] = slots.back();
+  slots[self->slot]->slot = self->slot;
+  slots.pop_back();
+  if (--state->nthreads) return;
 
   /* Nobody left, clean everything up.
 
@@ -318,8 +340,10 @@ void epoch_mgr::thread_fini() {
 bool epoch_mgr::thread_initialized() { return get_tls(this)->initialized; }
 
 epoch_mgr::epoch_num epoch_mgr::thread_enter() {
-  DIE_IF(not thread_initialized(), "Thread not initialized");
-  DIE_IF(thread_is_active(), "Thread already active");
+  // Look up our state once: get_tls is an indirect call
+  auto *self = get_tls(this);
+  DIE_IF(not self->initialized, "Thread not initialized");
+  DIE_IF(self->begin > self->end, "Thread already active");
 
   /* A thread is considered active if [begin] > [end]. Because this
      may not be our first transaction of the epoch, we may need to
@@ -328,8 +352,6 @@ epoch_mgr::epoch_num epoch_mgr::thread_enter() {
      If this operation races with an epoch end, it will make this
      thread look like a straggler from a previous epoch.
    */
-  auto *self = get_tls(this);
-  ASSERT(self->begin <= self->end);
 
 /* This operation here is racy.
 
@@ -436,8 +458,8 @@ epoch_mgr::epoch_num epoch_mgr::thread_quiesce() {
 }
 
 void epoch_mgr::thread_exit() {
-  DIE_IF(not thread_is_active(), "Thread not currently active");
   auto *self = get_tls(this);
+  DIE_IF(self->begin <= self->end, "Thread not currently active");
 
   __sync_synchronize();
   auto tmp = volatile_read(state->begin);
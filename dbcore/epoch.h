@@ -14,8 +14,12 @@ namespace ermia {
 struct epoch_mgr {
   typedef uint64_t epoch_num;
 
-  struct __attribute__((aligned(8))) tls_storage {
-    enum { SIZE = 32 };
+  /* A whole cache line: only its thread writes to it on enter/exit,
+     and the epoch advancer only reads it, so keep other thread-local
+     data from sharing the line.
+   */
+  struct __attribute__((aligned(64))) tls_storage {
+    enum { SIZE = 64 };
     char data[SIZE];
   };
 
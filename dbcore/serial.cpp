@@ -1,4 +1,9 @@
+#include <numa.h>
+
+#include <algorithm>
+
 #include "serial.h"
+#include "sm-config.h"
 #include "../macros.h"
 namespace ermia {
 
@@ -168,47 +173,84 @@ namespace TXN {
 */
 
 readers_list rlist;
-static thread_local readers_list::tls_bitmap_info tls_bitmap_infos[config::MAX_COROS];
 
-void assign_reader_bitmap_entry() {
-  if (tls_bitmap_infos[0].entry) return;
-
-  for (auto tls_bitmap_info : tls_bitmap_infos) {
-    for (uint32_t i = 0; i < readers_list::bitmap_t::ARRAY_SIZE; ++i) {
-    retry:
-      auto bits = volatile_read(rlist.bitmap.array[i]);
-      if (bits != ~uint64_t{0}) {
-        auto my_entry = bits + 1;
-        auto new_bits = bits | my_entry;
-        auto cur_bits =
-            __sync_val_compare_and_swap(&rlist.bitmap.array[i], bits, new_bits);
-        if (cur_bits == bits) {
-          ASSERT(tls_bitmap_info.entry == 0);
-          tls_bitmap_info.entry = my_entry;
-          tls_bitmap_info.index = i;
-          // return
-          break;
-        }
-        goto retry;
+bool readers_list::init() {
+  ALWAYS_ASSERT(config::max_threads);
+  uint64_t n = (uint64_t)config::max_threads * std::max<uint32_t>(config::coro_batch_size, 1);
+  capacity = std::min<uint64_t>((n + 63) / 64 * 64, kMaxCapacity);
+  bitmap = (uint64_t *)numa_alloc_interleaved(sizeof(uint64_t) * capacity / 64);
+  xids = (XID *)numa_alloc_interleaved(sizeof(XID) * capacity);
+  last_read_mostly_clsns = (uint64_t *)numa_alloc_interleaved(sizeof(uint64_t) * capacity);
+  LOG_IF(FATAL, !bitmap || !xids || !last_read_mostly_clsns) << "Unable to allocate reader slots";
+  memset(bitmap, 0, sizeof(uint64_t) * capacity / 64);
+  memset(xids, 0, sizeof(XID) * capacity);
+  memset(last_read_mostly_clsns, 0, sizeof(uint64_t) * capacity);
+  return true;
+}
+
+// One reader slot per coroutine of this thread, sized at runtime from
+// --coro_batch_size and allocated on the thread's node. Slots are taken from
+// rlist lazily when a coroutine starts its first transaction, so threads that
+// never run transactions (daemons, idle pool threads) don't use any up.
+static thread_local readers_list::tls_bitmap_info *tls_bitmap_infos = nullptr;
+static thread_local uint32_t tls_nbitmap_infos = 0;
+
+static void assign_reader_slot(readers_list::tls_bitmap_info &info) {
+  for (uint32_t i = 0; i < rlist.capacity / 64; ++i) {
+  retry:
+    auto bits = volatile_read(rlist.bitmap[i]);
+    if (bits != ~uint64_t{0}) {
+      auto my_entry = (bits + 1) & ~bits;  // lowest clear bit
+      auto new_bits = bits | my_entry;
+      auto cur_bits =
+          __sync_val_compare_and_swap(&rlist.bitmap[i], bits, new_bits);
+      if (cur_bits == bits) {
+        ASSERT(info.entry == 0);
+        info.entry = my_entry;
+        info.index = i;
+        return;
       }
+      goto retry;
     }
   }
+  LOG(FATAL) << "Out of SSN/SSI reader slots (" << rlist.capacity
+             << "), use fewer workers or a smaller --coro_batch_size";
+}
 
-  // ALWAYS_ASSERT(false);
+void assign_reader_bitmap_entry() {
+  static bool initialized = rlist.init();
+  MARK_REFERENCED(initialized);
+  if (tls_bitmap_infos) return;
+
+  tls_nbitmap_infos = std::max<uint32_t>(config::coro_batch_size, 1);
+  size_t size = sizeof(readers_list::tls_bitmap_info) * tls_nbitmap_infos;
+  tls_bitmap_infos = (readers_list::tls_bitmap_info *)numa_alloc_local(size);
+  LOG_IF(FATAL, !tls_bitmap_infos) << "Unable to allocate reader slots";
+  memset(tls_bitmap_infos, 0, size);
 }
 
 void deassign_reader_bitmap_entry() {
-  //ASSERT(tls_bitmap_info.entry);
-  //ASSERT(rlist.bitmap.array[tls_bitmap_info.index] & tls_bitmap_info.entry);
-  for (auto tls_bitmap_info : tls_bitmap_infos) {
-    __sync_fetch_and_xor(&rlist.bitmap.array[tls_bitmap_info.index],
-                         tls_bitmap_info.entry);
+  if (!tls_bitmap_infos) return;
+
+  for (uint32_t i = 0; i < tls_nbitmap_infos; ++i) {
+    auto &tls_bitmap_info = tls_bitmap_infos[i];
+    if (tls_bitmap_info.entry) {
+      __sync_fetch_and_xor(&rlist.bitmap[tls_bitmap_info.index],
+                           tls_bitmap_info.entry);
+    }
     tls_bitmap_info.entry = tls_bitmap_info.index = 0;
   }
+  numa_free(tls_bitmap_infos, sizeof(readers_list::tls_bitmap_info) * tls_nbitmap_infos);
+  tls_bitmap_infos = nullptr;
+  tls_nbitmap_infos = 0;
 }
 
 // register tx in the global rlist (called at tx start)
 void serial_register_tx(uint32_t coro_batch_idx, XID xid) {
+  ASSERT(coro_batch_idx < tls_nbitmap_infos);
+  if (unlikely(!tls_bitmap_infos[coro_batch_idx].entry)) {
+    assign_reader_slot(tls_bitmap_infos[coro_batch_idx]);
+  }
   ASSERT(not rlist.xids[tls_bitmap_infos[coro_batch_idx].xid_index()]._val);
   volatile_write(rlist.xids[tls_bitmap_infos[coro_batch_idx].xid_index()]._val, xid._val);
 }
@@ -221,32 +263,84 @@ void serial_deregister_tx(uint32_t coro_batch_idx, XID xid) {
   ASSERT(not rlist.xids[tls_bitmap_infos[coro_batch_idx].xid_index()]._val);
 }
 
-void serial_register_reader_tx(uint32_t coro_batch_idx, readers_list::bitmap_t* tuple_readers_bitmap) {
+// Calls [fn] on each of the version's reader slots, inline ones first, until
+// it returns true
+template <typename Fn>
+static inline bool for_each_reader_slot(reader_slots *readers, Fn fn) {
+  for (auto &slot : readers->slots) {
+    if (fn(slot)) {
+      return true;
+    }
+  }
+  for (auto *b = volatile_read(readers->spill); b; b = volatile_read(b->next)) {
+    for (auto &slot : b->slots) {
+      if (fn(slot)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void serial_register_reader_tx(uint32_t coro_batch_idx, reader_slots* tuple_readers) {
   ASSERT(tls_bitmap_infos[coro_batch_idx].entry);
-  ASSERT(rlist.bitmap.array[tls_bitmap_infos[coro_batch_idx].index] & tls_bitmap_info[coro_batch_idx].entry);
-  // With read optimization, a transaction might not clear the bit,
-  // so no need to set it again if it's set already (by a previous reader).
-  if (config::ssn_read_opt_enabled() &&
-      (volatile_read(tuple_readers_bitmap->array[tls_bitmap_infos[coro_batch_idx].index]) &
-       tls_bitmap_infos[coro_batch_idx].entry) != 0) {
+  uint16_t me = tls_bitmap_infos[coro_batch_idx].xid_index() + 1;
+
+  // With read optimization, a transaction might not deregister, and a
+  // transaction may read the same version more than once, so no need to
+  // register again if it's there already (by a previous reader).
+  if (for_each_reader_slot(tuple_readers, [&](uint16_t &slot) { return volatile_read(slot) == me; })) {
     return;
   }
-  __sync_fetch_and_or(&tuple_readers_bitmap->array[tls_bitmap_infos[coro_batch_idx].index],
-                      tls_bitmap_infos[coro_batch_idx].entry);
+
+  auto claim = [&](uint16_t &slot) {
+    return volatile_read(slot) == 0 && __sync_bool_compare_and_swap(&slot, 0, me);
+  };
+  while (!for_each_reader_slot(tuple_readers, claim)) {
+    // All taken, append a block with us in it. If someone else appended
+    // first, theirs probably has room.
+    reader_spill *b = nullptr;
+    int err = posix_memalign((void **)&b, CACHELINE_SIZE, sizeof(reader_spill));
+    LOG_IF(FATAL, err) << "Unable to allocate reader spill block";
+    memset(b, 0, sizeof(reader_spill));
+    b->slots[0] = me;
+
+    reader_spill **tail = &tuple_readers->spill;
+    while (volatile_read(*tail)) {
+      tail = &(*tail)->next;
+    }
+    if (__sync_bool_compare_and_swap(tail, nullptr, b)) {
+      return;
+    }
+    free(b);
+  }
 }
 
-void serial_deregister_reader_tx(uint32_t coro_batch_idx, readers_list::bitmap_t* tuple_readers_bitmap) {
-  ASSERT(tls_bitmap_info.entry);
+void serial_deregister_reader_tx(uint32_t coro_batch_idx, reader_slots* tuple_readers) {
+  ASSERT(tls_bitmap_infos[coro_batch_idx].entry);
+  uint16_t me = tls_bitmap_infos[coro_batch_idx].xid_index() + 1;
+
   // if a tx reads a tuple multiple times (e.g., 3 times),
   // then during post-commit it will call this function
-  // multiple times, so we take a look to see if it's still set before the xor.
-  auto b = volatile_read(tuple_readers_bitmap->array[tls_bitmap_infos[coro_batch_idx].index]);
-  if (b & tls_bitmap_infos[coro_batch_idx].entry) {
-    __sync_fetch_and_xor(&tuple_readers_bitmap->array[tls_bitmap_infos[coro_batch_idx].index],
-                         tls_bitmap_infos[coro_batch_idx].entry);
+  // multiple times, so we take a look to see if it's still there.
+  for_each_reader_slot(tuple_readers, [&](uint16_t &slot) {
+    if (volatile_read(slot) == me) {
+      // Only I can clear my own slot, others only CAS free slots
+      volatile_write(slot, 0);
+      return true;
+    }
+    return false;
+  });
+}
+
+void serial_purge_readers(reader_slots* tuple_readers) {
+  auto *b = volatile_read(tuple_readers->spill);
+  while (b) {
+    auto *next = b->next;
+    free(b);
+    b = next;
   }
-  ASSERT(not(tuple_readers_bitmap->array[tls_bitmap_infos[coro_batch_idx].index] &
-             tls_bitmap_infos[coro_batch_idx].entry));
+  volatile_write(tuple_readers->spill, nullptr);
 }
 
 void serial_stamp_last_committed_lsn(uint32_t coro_batch_idx, uint64_t lsn) {
@@ -258,32 +352,39 @@ uint64_t serial_get_last_read_mostly_cstamp(int xid_idx) {
   return volatile_read(rlist.last_read_mostly_clsns[xid_idx]);
 }
 
-bool readers_list::bitmap_t::is_empty(uint32_t coro_batch_idx, bool exclude_self) {
-  for (uint32_t i = 0; i < ARRAY_SIZE; ++i) {
-    auto bits = volatile_read(array[i]);
-    if (bits) {
-      if (exclude_self and i == tls_bitmap_infos[coro_batch_idx].index and
-          bits == tls_bitmap_infos[coro_batch_idx].entry)
-        continue;
-      return false;
-    }
+bool reader_slots::is_empty(uint32_t coro_batch_idx, bool exclude_self) {
+  uint16_t me = exclude_self ? tls_bitmap_infos[coro_batch_idx].xid_index() + 1 : 0;
+  return !for_each_reader_slot(this, [&](uint16_t &slot) {
+    auto s = volatile_read(slot);
+    return s && s != me;
+  });
+}
+
+readers_iterator::readers_iterator(reader_slots* readers) : cur(0) {
+  for (uint32_t i = 0; i < reader_slots::kInlineSlots; ++i) {
+    inline_slots[i] = volatile_read(readers->slots[i]);
   }
-  return true;
+  spill = volatile_read(readers->spill);
 }
 
-int32_t readers_bitmap_iterator::next(uint32_t coro_batch_idx, bool skip_self) {
+int32_t readers_iterator::next(uint32_t coro_batch_idx, bool skip_self) {
+  uint16_t me = skip_self ? tls_bitmap_infos[coro_batch_idx].xid_index() + 1 : 0;
   while (true) {
-    if (cur_entry) {
-      auto pos = __builtin_ctzll(cur_entry);
-      cur_entry &= (cur_entry - 1);
-      if (skip_self and cur_entry_index == tls_bitmap_infos[coro_batch_idx].index and
-          pos == __builtin_ctzll(tls_bitmap_infos[coro_batch_idx].entry)) {
-        continue;
+    uint16_t slot = 0;
+    if (cur < reader_slots::kInlineSlots) {
+      slot = inline_slots[cur++];
+    } else if (!spill) {
+      return -1;
+    } else {
+      slot = volatile_read(spill->slots[cur++ - reader_slots::kInlineSlots]);
+      if (cur == reader_slots::kInlineSlots + reader_spill::kSlots) {
+        spill = volatile_read(spill->next);
+        cur = reader_slots::kInlineSlots;
       }
-      return cur_entry_index * 64 + pos;
     }
-    if ((cur_entry_index + 1) * 64 >= readers_list::bitmap_t::CAPACITY) return -1;
-    cur_entry = volatile_read(array[++cur_entry_index]);
+    if (slot && slot != me) {
+      return slot - 1;
+    }
   }
 }
 
@@ -28,59 +28,81 @@ inline bool ssn_check_exclusion(xid_context* xc) {
 
 struct readers_list {
   /*
-   * A bitmap to account for readers in a tuple. One bit per reader thread.
-   * Having four uint64_t enables us to support 256 concurrent readers at most.
-   * 256 / 8 = 64 bytes = one cache line.
+   * Reader slots: one bit per reader, i.e., per coroutine of a thread that
+   * runs transactions (slots are taken lazily). Versions don't embed this
+   * bitmap but record slot numbers in reader_slots below, so it's sized at
+   * first use for config::max_threads threads with --coro_batch_size
+   * coroutines each, up to what a reader slot number can hold.
    */
-  struct bitmap_t {
-    static const uint32_t CAPACITY =
-        config::MAX_THREADS * config::MAX_COROS;  // must be a multiple of 64
-    static const uint32_t ARRAY_SIZE = CAPACITY / 64;
-    uint64_t array[ARRAY_SIZE];
-
-    bitmap_t() { memset(array, '\0', sizeof(uint64_t) * ARRAY_SIZE); }
-
-    bool is_empty(uint32_t coro_batch_idx, bool exclude_self);
-  };
+  static const uint32_t kMaxCapacity = (UINT16_MAX - 1) / 64 * 64;
 
   struct tls_bitmap_info {
     uint64_t entry;  // the entry with my bit set
-    uint32_t index;  // which uint64_t in bitmap_t.array
+    uint32_t index;  // which uint64_t in bitmap
     inline uint32_t xid_index() {
       ASSERT(entry);
       return index * 64 + __builtin_ctzll(entry);
     }
   };
 
-  bitmap_t bitmap;
-  XID xids[bitmap_t::CAPACITY];  // one xid per bit position
-  uint64_t last_read_mostly_clsns[bitmap_t::CAPACITY];
+  uint32_t capacity;  // a multiple of 64
+  uint64_t *bitmap;   // [capacity / 64]
+  XID *xids;          // one xid per bit position
+  uint64_t *last_read_mostly_clsns;
 
-  readers_list() {
-    memset(xids, '\0', sizeof(XID) * bitmap_t::CAPACITY);
-    memset(last_read_mostly_clsns, '\0', sizeof(LSN) * bitmap_t::CAPACITY);
-  }
+  readers_list()
+      : capacity(0), bitmap(nullptr), xids(nullptr), last_read_mostly_clsns(nullptr) {}
+  bool init();
+};
+
+/*
+ * In-flight readers of a version. Most versions have no or very few
+ * concurrent readers, so instead of one bit per possible reader each version
+ * keeps a few inline slots (reader slot number + 1, 0 - free). Further
+ * readers go to cache line-sized spill blocks chained off the version, which
+ * they CAS themselves into just like the inline slots. Blocks stay until the
+ * version is recycled (serial_purge_readers), so walking them needs no lock.
+ */
+struct reader_spill {
+  static const uint32_t kSlots = (CACHELINE_SIZE - sizeof(void *)) / sizeof(uint16_t);
+  uint16_t slots[kSlots];
+  reader_spill *next;
+} CACHE_ALIGNED;
+
+struct reader_slots {
+  static const uint32_t kInlineSlots = 4;
+  uint16_t slots[kInlineSlots];
+  reader_spill *spill;
+
+  reader_slots() : spill(nullptr) { memset(slots, '\0', sizeof(slots)); }
+
+  bool is_empty(uint32_t coro_batch_idx, bool exclude_self);
 };
+static_assert(sizeof(reader_slots) == 2 * sizeof(uint64_t), "reader_slots grew");
+static_assert(readers_list::kMaxCapacity < UINT16_MAX, "Reader slot number overflow");
 
 uint64_t serial_get_last_read_mostly_cstamp(int xid_idx);
 void serial_stamp_last_committed_lsn(uint32_t coro_batch_idx, uint64_t lsn);
-void serial_deregister_reader_tx(uint32_t coro_batch_idx, readers_list::bitmap_t* tuple_readers_bitmap);
-void serial_register_reader_tx(uint32_t coro_batch_idx, readers_list::bitmap_t* tuple_readers_bitmap);
+void serial_deregister_reader_tx(uint32_t coro_batch_idx, reader_slots* tuple_readers);
+void serial_register_reader_tx(uint32_t coro_batch_idx, reader_slots* tuple_readers);
 void serial_register_tx(uint32_t coro_batch_idx, XID xid);
 void serial_deregister_tx(uint32_t coro_batch_idx, XID xid);
 
+// Free the spill blocks of a version that's about to be recycled (readers of
+// old versions may never deregister)
+void serial_purge_readers(reader_slots* tuple_readers);
+
 extern readers_list rlist;
 
-struct readers_bitmap_iterator {
-  readers_bitmap_iterator(readers_list::bitmap_t* bitmap)
-      : array(bitmap->array),
-        cur_entry_index(0),
-        cur_entry(volatile_read(array[0])) {}
+// Walks a version's readers (a snapshot of the inline slots, then the spill
+// blocks as they are), returning their slot numbers (index into rlist.xids)
+struct readers_iterator {
+  readers_iterator(reader_slots* readers);
 
   int32_t next(uint32_t coro_batch_idx, bool skip_self = true);
-  uint64_t* array;
-  uint32_t cur_entry_index;
-  uint64_t cur_entry;
+  uint16_t inline_slots[reader_slots::kInlineSlots];
+  reader_spill *spill;  // block being walked once past the inline slots
+  uint32_t cur;
 };
 }  // namespace TXN
 #endif
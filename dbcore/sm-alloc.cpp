@@ -1,14 +1,20 @@
 #include <numa.h>
+#include <numaif.h>
 #include <sched.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include <atomic>
-#include <future>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "sm-alloc.h"
 #include "sm-chkpt.h"
 #include "sm-common.h"
 #include "sm-object.h"
+#include "../macros.h"
 #include "../txn.h"
 
 namespace ermia {
@@ -56,37 +62,288 @@ uint64_t *allocated_node_memory = nullptr;
 static uint64_t thread_local tls_allocated_node_memory CACHE_ALIGNED;
 static const uint64_t tls_node_memory_mb = 200;
 
+// Per-node depot of free object batches that overflowed from threads'
+// TlsFreeObjectPools, by size code
+struct FreeObjectDepot {
+  uint32_t lock;
+  uint64_t bytes;
+  uint64_t nbatches;
+  std::unordered_map<uint16_t, std::vector<std::vector<uint64_t>>> batches;
+
+  inline void Lock() {
+    while (!__sync_bool_compare_and_swap(&lock, 0, 1)) {
+      NOP_PAUSE;
+    }
+  }
+  inline void Unlock() { __sync_lock_release(&lock); }
+} CACHE_ALIGNED;
+
+static FreeObjectDepot *free_object_depots = nullptr;
+
+// Every thread's TlsFreeObjectPool, for stats
+static std::mutex free_object_pools_lock;
+static std::vector<TlsFreeObjectPool *> free_object_pools;
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+// How each node pool is backed, and how much of it the populator has
+// faulted in so far
+static node_page_kind *node_page_kinds = nullptr;
+static uint64_t *populated_node_memory = nullptr;
+// Joined by wait_node_memory_populated(); leaked so that threads still
+// unjoined at an early exit don't call std::terminate from the destructor
+static std::vector<std::thread> *node_populators = nullptr;
+
+// Warn once per node when a pool crosses this fraction of its size
+static const double kNodeMemoryWarnFraction = 0.9;
+
+const char *page_kind_name(node_page_kind k) {
+  switch (k) {
+  case node_page_kind::hugetlb:
+    return "2MB (hugetlbfs)";
+  case node_page_kind::thp:
+    return "2MB (transparent)";
+  default:
+    return "4KB";
+  }
+}
+
+// Whether the kernel would back an madvise(MADV_HUGEPAGE)'d region with
+// transparent huge pages at all; madvise itself succeeds either way.
+static bool thp_enabled() {
+  std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string mode;
+  std::getline(f, mode);
+  return mode.find("[always]") != std::string::npos ||
+         mode.find("[madvise]") != std::string::npos;
+}
+
+// Reserve [size] bytes of address space for a node pool. Explicit huge
+// pages first; mmap fails right away if not enough of them are reserved
+// since we don't pass MAP_NORESERVE. Then normal pages with THP, then
+// plain normal pages.
+static char *map_node_pool(uint64_t size, node_page_kind &kind) {
+  void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) {
+    kind = node_page_kind::hugetlb;
+    return (char *)p;
+  }
+  p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE,
+           -1, 0);
+  THROW_IF(p == MAP_FAILED, os_error, errno, "Unable to allocate node memory");
+  bool thp = !madvise(p, size, MADV_HUGEPAGE) && thp_enabled();
+  kind = thp ? node_page_kind::thp : node_page_kind::normal;
+  return (char *)p;
+}
+
+// Fault in a node pool front to back, [kPopulateChunk] at a time, so that
+// loading doesn't wait for all of it. Allocation is a bump pointer from
+// the front, so this mostly stays ahead of it; anything it hasn't reached
+// yet simply faults on first touch. Page placement follows the pool's
+// mbind policy, not this thread's.
+static void populate_node_pool(int node) {
+  static const uint64_t kPopulateChunk = 64 * config::MB;
+  uint64_t size = config::node_memory_gb * config::GB;
+  bool use_madvise = true;
+  for (uint64_t off = 0; off < size; off += kPopulateChunk) {
+    char *p = node_memory[node] + off;
+    uint64_t len = std::min(kPopulateChunk, size - off);
+    if (use_madvise && madvise(p, len, MADV_POPULATE_WRITE)) {
+      // Pre-5.14 kernel: write-fault by hand. Workers may already be using
+      // the memory, so the write must not change anything.
+      use_madvise = false;
+    }
+    if (!use_madvise) {
+      static const long page = sysconf(_SC_PAGESIZE);
+      for (uint64_t i = 0; i < len; i += page) {
+        __atomic_fetch_add(p + i, 0, __ATOMIC_RELAXED);
+      }
+    }
+    volatile_write(populated_node_memory[node], off + len);
+  }
+  LOG(INFO) << "Populated " << config::node_memory_gb << "GB on node " << node;
+}
+
 void prepare_node_memory() {
   if (!config::tls_alloc) {
     return;
   }
 
   ALWAYS_ASSERT(config::numa_nodes);
+  ALWAYS_ASSERT(config::node_memory_gb);
   allocated_node_memory =
       (uint64_t *)malloc(sizeof(uint64_t) * config::numa_nodes);
   node_memory = (char **)malloc(sizeof(char *) * config::numa_nodes);
-  std::vector<std::future<void> > futures;
+  node_page_kinds =
+      (node_page_kind *)malloc(sizeof(node_page_kind) * config::numa_nodes);
+  populated_node_memory =
+      (uint64_t *)malloc(sizeof(uint64_t) * config::numa_nodes);
+  node_populators = new std::vector<std::thread>;
   LOG(INFO) << "Will run and allocate on " << config::numa_nodes << " nodes, "
             << config::node_memory_gb << "GB each";
+  free_object_depots = new FreeObjectDepot[config::numa_nodes];
+  uint64_t size = config::node_memory_gb * config::GB;
+  for (int i = 0; i < config::numa_nodes; i++) {
+    free_object_depots[i].lock = 0;
+    free_object_depots[i].bytes = 0;
+    free_object_depots[i].nbatches = 0;
+    allocated_node_memory[i] = 0;
+    populated_node_memory[i] = 0;
+    node_memory[i] = map_node_pool(size, node_page_kinds[i]);
+
+    struct bitmask *mask = numa_bitmask_alloc(numa_num_possible_nodes());
+    numa_bitmask_setbit(mask, i);
+    long err = mbind(node_memory[i], size, MPOL_PREFERRED, mask->maskp,
+                     mask->size + 1, 0);
+    numa_bitmask_free(mask);
+    LOG_IF(WARNING, err) << "Unable to bind node " << i
+                         << " memory: " << strerror(errno);
+
+    LOG(INFO) << "Reserved " << config::node_memory_gb << "GB on node " << i
+              << " with " << page_kind_name(node_page_kinds[i]) << " pages";
+    node_populators->emplace_back(populate_node_pool, i);
+  }
+}
+
+void wait_node_memory_populated() {
+  if (!node_populators) {
+    return;
+  }
+  for (auto &t : *node_populators) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+}
+
+node_memory_stats get_node_memory_stats(int node) {
+  node_memory_stats s = {0, 0, 0, node_page_kind::normal};
+  if (!node_memory) {
+    return s;
+  }
+  s.reserved = config::node_memory_gb * config::GB;
+  s.used = std::min(volatile_read(allocated_node_memory[node]), s.reserved);
+  s.populated = volatile_read(populated_node_memory[node]);
+  s.pages = node_page_kinds[node];
+  return s;
+}
+
+void print_node_memory_stats(std::ostream &os) {
+  if (!node_memory) {
+    return;
+  }
+  for (int i = 0; i < config::numa_nodes; i++) {
+    auto s = get_node_memory_stats(i);
+    os << "node_memory[" << i << "]: used " << s.used / config::MB
+       << "MB, reserved " << s.reserved / config::MB << "MB, free "
+       << (s.reserved - s.used) / config::MB << "MB, populated "
+       << s.populated / config::MB
+       << "MB, pages " << page_kind_name(s.pages) << std::endl;
+  }
+}
+
+free_object_totals get_free_object_totals() {
+  free_object_totals t = {0, 0, 0};
+  std::lock_guard<std::mutex> guard(free_object_pools_lock);
+  for (auto *p : free_object_pools) {
+    t.recycled += p->recycled();
+    t.recycled_bytes += p->recycled_bytes();
+    t.cached_bytes += p->bytes();
+  }
+  return t;
+}
+
+void print_free_object_stats(std::ostream &os) {
+  {
+    std::lock_guard<std::mutex> guard(free_object_pools_lock);
+    for (uint32_t i = 0; i < free_object_pools.size(); ++i) {
+      auto *p = free_object_pools[i];
+      if (p->bytes() || p->overflows() || p->refills()) {
+        os << "free_objects[" << i << "]: node " << p->node() << ", cached "
+           << p->bytes() / 1024 << "KB, " << p->overflows() << " batches out, "
+           << p->refills() << " batches in" << std::endl;
+      }
+    }
+  }
+  if (!free_object_depots) {
+    return;
+  }
   for (int i = 0; i < config::numa_nodes; i++) {
-    LOG(INFO) << "Allocating " << config::node_memory_gb << "GB on node " << i;
-    auto f = [=] {
-      ALWAYS_ASSERT(config::node_memory_gb);
-      allocated_node_memory[i] = 0;
-      numa_set_preferred(i);
-      node_memory[i] = (char *)mmap(
-          nullptr, config::node_memory_gb * config::GB, PROT_READ | PROT_WRITE,
-          MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB | MAP_POPULATE, -1, 0);
-      THROW_IF(node_memory[i] == nullptr or node_memory[i] == MAP_FAILED,
-               os_error, errno, "Unable to allocate huge pages");
-      ALWAYS_ASSERT(node_memory[i]);
-      LOG(INFO) << "Allocated " << config::node_memory_gb << "GB on node " << i;
-    };
-    futures.push_back(std::async(std::launch::async, f));
-  }
-  for (auto &f : futures) {
-    f.get();
+    auto &d = free_object_depots[i];
+    d.Lock();
+    uint64_t bytes = d.bytes;
+    uint64_t nbatches = d.nbatches;
+    d.Unlock();
+    os << "free_object_depot[" << i << "]: " << bytes / 1024 << "KB in "
+       << nbatches << " batches" << std::endl;
+  }
+}
+
+TlsFreeObjectPool::TlsFreeObjectPool()
+    : bytes_(0), overflows_(0), refills_(0), recycled_(0), recycled_bytes_(0) {
+  // Threads on nodes we don't allocate on (e.g., with a smaller --numa_nodes)
+  // or whose node is unknown go to node 0's depot
+  int node = numa_node_of_cpu(sched_getcpu());
+  node_ = (node < 0 || node >= config::numa_nodes) ? 0 : node;
+  std::lock_guard<std::mutex> guard(free_object_pools_lock);
+  free_object_pools.push_back(this);
+}
+
+void TlsFreeObjectPool::Overflow(uint16_t size_code) {
+  if (!free_object_depots) {
+    return;  // no depots without node memory, just keep everything
+  }
+  auto *set = pool_[size_code];
+  std::vector<uint64_t> batch;
+  batch.reserve(kBatchSize);
+  for (auto it = set->begin(); it != set->end() && batch.size() < kBatchSize;) {
+    batch.push_back(*it);
+    it = set->erase(it);
+  }
+  uint64_t batch_bytes = batch.size() * decode_size_aligned(size_code);
+  bytes_ -= batch_bytes;
+  ++overflows_;
+
+  auto &d = free_object_depots[node_];
+  d.Lock();
+  d.batches[size_code].emplace_back(std::move(batch));
+  d.bytes += batch_bytes;
+  ++d.nbatches;
+  d.Unlock();
+}
+
+bool TlsFreeObjectPool::Refill(uint16_t size_code) {
+  if (!free_object_depots) {
+    return false;
+  }
+  auto &d = free_object_depots[node_];
+  if (!volatile_read(d.nbatches)) {
+    return false;
+  }
+  std::vector<uint64_t> batch;
+  d.Lock();
+  auto it = d.batches.find(size_code);
+  if (it != d.batches.end() && !it->second.empty()) {
+    batch = std::move(it->second.back());
+    it->second.pop_back();
+    d.bytes -= batch.size() * decode_size_aligned(size_code);
+    --d.nbatches;
+  }
+  d.Unlock();
+  if (batch.empty()) {
+    return false;
+  }
+
+  if (pool_.find(size_code) == pool_.end()) {
+    pool_[size_code] = new std::unordered_set<uint64_t>;
   }
+  pool_[size_code]->insert(batch.begin(), batch.end());
+  bytes_ += batch.size() * decode_size_aligned(size_code);
+  ++refills_;
+  return true;
 }
 
 void gc_version_chain(fat_ptr *oid_entry) {
@@ -155,6 +412,9 @@ void gc_version_chain(fat_ptr *oid_entry) {
         ALWAYS_ASSERT(clsn.asi_type() == fat_ptr::ASI_LOG);
         ALWAYS_ASSERT(LSN::from_ptr(clsn).offset() <= glsn);
         fat_ptr next_ptr = cur_obj->GetNextVolatile();
+#if defined(SSN) || defined(SSI)
+        TXN::serial_purge_readers(&((dbtuple *)cur_obj->GetPayload())->readers);
+#endif
         cur_obj->SetClsn(NULL_PTR);
         cur_obj->SetNextVolatile(NULL_PTR);
         if (!tls_free_object_pool) {
@@ -216,7 +476,13 @@ void *allocate_onnode(size_t size) {
   auto node = numa_node_of_cpu(sched_getcpu());
   ALWAYS_ASSERT(node < config::numa_nodes);
   auto offset = __sync_fetch_and_add(&allocated_node_memory[node], size);
-  if (likely(offset + size <= config::node_memory_gb * config::GB)) {
+  uint64_t pool_size = config::node_memory_gb * config::GB;
+  uint64_t warn_mark = pool_size * kNodeMemoryWarnFraction;
+  LOG_IF(WARNING, offset < warn_mark && offset + size >= warn_mark)
+      << "Node " << node << " memory is " << kNodeMemoryWarnFraction * 100
+      << "% used (" << (offset + size) / config::MB << "MB of "
+      << pool_size / config::MB << "MB)";
+  if (likely(offset + size <= pool_size)) {
     return node_memory[node] + offset;
   }
   return nullptr;
@@ -227,6 +493,9 @@ void deallocate(fat_ptr p) {
   ASSERT(p.size_code());
   ASSERT(p.size_code() != INVALID_SIZE_CODE);
   Object *obj = (Object *)p.offset();
+#if defined(SSN) || defined(SSI)
+  TXN::serial_purge_readers(&((dbtuple *)obj->GetPayload())->readers);
+#endif
   obj->SetNextVolatile(NULL_PTR);
   obj->SetClsn(NULL_PTR);
   if (!tls_free_object_pool) {
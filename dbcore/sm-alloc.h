@@ -1,4 +1,5 @@
 #pragma once
+#include <ostream>
 #include <unordered_map>
 #include <unordered_set>
 #include "sm-config.h"
@@ -54,21 +55,26 @@ void gc_version_chain(fat_ptr *oid_entry);
 
 extern epoch_num gc_epoch;
 
-// A hashtab storing recycled (freed) objects by size. No CC.
+// A hashtab storing recycled (freed) objects by size. No CC. Holds at most
+// config::tls_free_cache_mb of objects; past that, a batch of the size class
+// being freed overflows into this thread's node depot. A miss pulls a batch
+// of the size class back from the depot, so memory freed by threads that do
+// most of the GC gets reused by threads on the same node that allocate.
 class TlsFreeObjectPool {
  private:
   // The unordered_set stores a fat_ptr (just in the form of an int)
   std::unordered_map<size_t, std::unordered_set<uint64_t> *> pool_;
+  uint64_t bytes_;       // cached here
+  uint32_t node_;
+  uint64_t overflows_;   // batches pushed to the depot
+  uint64_t refills_;     // batches pulled from the depot
+  uint64_t recycled_;    // objects put here by GC and deallocation
+  uint64_t recycled_bytes_;
 
- public:
-  TlsFreeObjectPool() {}
-  inline void Put(fat_ptr ptr) {
-    if (pool_.find(ptr.size_code()) == pool_.end()) {
-      pool_[ptr.size_code()] = new std::unordered_set<uint64_t>;
-    }
-    pool_[ptr.size_code()]->insert(ptr._ptr);
-  }
-  inline fat_ptr Get(uint16_t size_code) {
+  void Overflow(uint16_t size_code);
+  bool Refill(uint16_t size_code);
+
+  inline fat_ptr TryGet(uint16_t size_code) {
     if (pool_.find(size_code) != pool_.end()) {
       auto *set = pool_[size_code];
       uint32_t tries = 10;
@@ -78,6 +84,7 @@ class TlsFreeObjectPool {
           Object *obj = (Object *)ret_ptr.offset();
           if (obj->GetAllocateEpoch() < gc_epoch) {
             set->erase(p);
+            bytes_ -= decode_size_aligned(size_code);
             return ret_ptr;
           }
           // XXX(tzwang): try a few times, too slow to look at all candidates.
@@ -92,6 +99,37 @@ class TlsFreeObjectPool {
     }
     return NULL_PTR;
   }
+
+ public:
+  static const uint32_t kBatchSize = 64;
+
+  TlsFreeObjectPool();
+  inline void Put(fat_ptr ptr) {
+    if (pool_.find(ptr.size_code()) == pool_.end()) {
+      pool_[ptr.size_code()] = new std::unordered_set<uint64_t>;
+    }
+    pool_[ptr.size_code()]->insert(ptr._ptr);
+    bytes_ += decode_size_aligned(ptr.size_code());
+    ++recycled_;
+    recycled_bytes_ += decode_size_aligned(ptr.size_code());
+    if (unlikely(bytes_ > config::tls_free_cache_mb * config::MB)) {
+      Overflow(ptr.size_code());
+    }
+  }
+  inline fat_ptr Get(uint16_t size_code) {
+    fat_ptr ptr = TryGet(size_code);
+    if (ptr == NULL_PTR && Refill(size_code)) {
+      ptr = TryGet(size_code);
+    }
+    return ptr;
+  }
+
+  inline uint64_t bytes() { return volatile_read(bytes_); }
+  inline uint32_t node() { return node_; }
+  inline uint64_t overflows() { return volatile_read(overflows_); }
+  inline uint64_t refills() { return volatile_read(refills_); }
+  inline uint64_t recycled() { return volatile_read(recycled_); }
+  inline uint64_t recycled_bytes() { return volatile_read(recycled_bytes_); }
 };
 
 extern uint64_t safesnap_lsn;
@@ -103,7 +141,36 @@ struct thread_data {
   uint64_t counts;
 };
 
+// How a node pool ended up being backed, best first
+enum class node_page_kind : uint8_t { hugetlb, thp, normal };
+
+// Reserve a pool of config::node_memory_gb on each node and start faulting
+// it in in the background
 void prepare_node_memory();
+// Wait for the above to finish, so that it doesn't skew measurements
+void wait_node_memory_populated();
+
+struct node_memory_stats {
+  uint64_t used;
+  uint64_t reserved;
+  uint64_t populated;
+  node_page_kind pages;
+};
+// Zeroes if node pools aren't in use
+node_memory_stats get_node_memory_stats(int node);
+const char *page_kind_name(node_page_kind kind);
+// Per-node used/reserved/free/populated bytes and the page size in use
+void print_node_memory_stats(std::ostream &os);
+
+// Summed over all threads' free object pools
+struct free_object_totals {
+  uint64_t recycled;        // objects reclaimed by GC or deallocated
+  uint64_t recycled_bytes;
+  uint64_t cached_bytes;    // still in thread caches
+};
+free_object_totals get_free_object_totals();
+// Free object bytes cached by each thread and held by each node's depot
+void print_free_object_stats(std::ostream &os);
 void *allocate(size_t size);
 void deallocate(fat_ptr p);
 void *allocate_onnode(size_t size);
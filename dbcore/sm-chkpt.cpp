@@ -31,6 +31,7 @@ void sm_chkpt_mgr::take(bool wait) {
 }
 
 void sm_chkpt_mgr::daemon() {
+  thread::PinDaemon(thread::kDaemonCheckpoint);
   RCU::rcu_register();
   while (!volatile_read(_shutdown)) {
     std::unique_lock<std::mutex> lock(_daemon_mutex);
@@ -2,6 +2,7 @@
 #include "sm-cmd-log.h"
 #include "sm-log.h"
 #include "sm-rep.h"
+#include "sm-thread.h"
 #include "../util.h"
 
 namespace ermia {
@@ -110,6 +111,7 @@ void CommandLogManager::Flush(bool check_tls) {
 }
 
 void CommandLogManager::BackgroundReplayDaemon() {
+  thread::PinDaemon(thread::kDaemonReplication);
   bg_buffer = (char*)malloc(config::group_commit_bytes);
   dirent_iterator dir(config::log_dir.c_str());
   int dfd = dir.dup();
@@ -254,6 +256,7 @@ void CommandLogManager::ShipLog(char *buf, uint32_t size) {
 }
 
 void CommandLogManager::FlushDaemon() {
+  thread::PinDaemon(thread::kDaemonCommit);
   while (!shutdown_) {
     while (!shutdown_ && !(flush_status_ & 1)) {
       // Maybe can sleep
@@ -69,8 +69,8 @@ public:
     buffer_ = (char*)malloc(buf_size);
     memset(buffer_, 0, buf_size);
 
-    tls_offsets_ = (uint64_t *)malloc(sizeof(uint64_t) * config::MAX_THREADS);
-    memset(tls_offsets_, 0, sizeof(uint64_t) * config::MAX_THREADS);
+    tls_offsets_ = (uint64_t *)malloc(sizeof(uint64_t) * config::max_threads);
+    memset(tls_offsets_, 0, sizeof(uint64_t) * config::max_threads);
 
     replayed_offset = 0;
     next_replay_offset[0] = next_replay_offset[1] = 0;
@@ -10,15 +10,23 @@ namespace ermia {
 namespace config {
 
 uint32_t arena_size_mb = 4;
+uint32_t tls_free_cache_mb = 64;
 bool threadpool = true;
 bool tls_alloc = true;
 bool verbose = true;
 bool coro_tx = false;
+uint32_t coro_workers = 0;
+std::string coro_sequential_txns("");
 uint32_t coro_batch_size = 1;
 bool coro_batch_schedule = false;
+bool coro_adaptive_batch = false;
+uint32_t coro_min_batch_size = 1;
+uint32_t coro_long_txn_interval = 4;
+bool coro_batch_probe_cache = true;
 bool scan_with_it = false;
 std::string benchmark("");
 uint32_t worker_threads = 0;
+uint32_t max_threads = 0;
 uint32_t benchmark_seconds = 30;
 uint32_t benchmark_scale_factor = 1;
 bool parallel_loading = false;
@@ -46,9 +54,15 @@ std::string primary_port("10000");
 bool htt_is_on = true;
 bool physical_workers_only = true;
 bool print_cpu_util = false;
+bool print_latency_percentiles = false;
+std::string results_json("");
 bool enable_perf = false;
 std::string perf_record_event("");
+bool work_stealing = false;
+double arrival_rate = 0;
+bool arrival_poisson = true;
 uint64_t node_memory_gb = 12;
+bool oid_numa_partition = false;
 bool log_ship_offset_replay = false;
 int recovery_warm_up_policy = WARM_UP_NONE;
 int log_ship_warm_up_policy = WARM_UP_NONE;
@@ -80,6 +94,7 @@ uint32_t command_log_buffer_mb = 16;
 bool index_probe_only = false;
 bool amac_version_chain = false;
 bool numa_spread = false;
+std::string placement_policy;
 
 void init() {
   ALWAYS_ASSERT(threads);
@@ -104,6 +119,19 @@ void sanity_check() {
   ALWAYS_ASSERT(recover_functor || is_backup_srv());
   ALWAYS_ASSERT(numa_nodes || !threadpool);
   ALWAYS_ASSERT(not group_commit or group_commit_queue_length);
+  LOG_IF(FATAL, coro_tx && !coro_batch_size) << "Need at least one coroutine slot";
+  LOG_IF(FATAL, coro_workers > worker_threads) << "More coroutine workers than workers";
+  LOG_IF(FATAL, coro_workers && !coro_tx) << "Coroutine workers need --coro_tx";
+  LOG_IF(FATAL, !coro_sequential_txns.empty() && !coro_tx) << "Sequential coroutine types need --coro_tx";
+#ifdef ADV_COROUTINE
+  LOG_IF(FATAL, coro_tx && coro_workers != worker_threads) << "Sequential workers not supported in this build";
+#endif
+  LOG_IF(FATAL, !coro_long_txn_interval) << "Long transactions must get resumed";
+  LOG_IF(FATAL, arrival_rate < 0) << "Invalid arrival rate " << arrival_rate;
+  LOG_IF(FATAL, work_stealing && !arrival_rate) << "Work stealing needs open-loop arrivals to steal";
+  LOG_IF(FATAL, work_stealing && coro_batch_schedule) << "Batch scheduler runs one type per batch, can't steal";
+  LOG_IF(FATAL, coro_adaptive_batch && (!coro_min_batch_size || coro_min_batch_size > coro_batch_size))
+    << "Invalid adaptive batch size range [" << coro_min_batch_size << ", " << coro_batch_size << "]";
   if (is_backup_srv()) {
     // Must have replay threads if replay is wanted
     ALWAYS_ASSERT(replay_policy == kReplayNone || replay_threads > 0);
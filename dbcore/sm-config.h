@@ -13,8 +13,7 @@ struct sm_log_recover_impl;
 
 namespace config {
 
-static const uint32_t MAX_THREADS = 96;
-static const uint32_t MAX_COROS = 8;
+static const uint32_t kMaxNumaNodes = 64;
 static const uint64_t MB = 1024 * 1024;
 static const uint64_t GB = MB * 1024;
 
@@ -26,8 +25,10 @@ extern std::string benchmark;
 extern uint32_t benchmark_scale_factor;
 extern uint32_t threads;
 extern uint32_t worker_threads;
+extern uint32_t max_threads;  // thread IDs available, sized from the topology
 extern int numa_nodes;
 extern bool numa_spread;
+extern std::string placement_policy;
 extern std::string tmpfs_dir;
 extern bool htt_is_on;
 extern bool physical_workers_only;
@@ -42,15 +43,26 @@ extern std::string read_view_stat_file;
 extern bool command_log;
 extern uint32_t command_log_buffer_mb;
 extern bool print_cpu_util;
+extern bool print_latency_percentiles;
+// Where to write the run's settings and results as JSON, if anywhere
+extern std::string results_json;
 extern uint32_t arena_size_mb;
+extern uint32_t tls_free_cache_mb;
 extern bool enable_perf;
 extern std::string perf_record_event;
+extern bool work_stealing;
+
+// Open-loop load: transactions/s offered over all workers (0 = closed loop),
+// with Poisson or evenly spaced arrivals
+extern double arrival_rate;
+extern bool arrival_poisson;
 
 // NVRAM settings - for backup servers only, the primary doesn't care.
 extern bool nvram_log_buffer;
 extern uint32_t nvram_delay_type;
 extern sm_log_recover_impl *recover_functor;
 extern uint64_t node_memory_gb;
+extern bool oid_numa_partition;  // node-local OID extents, see oid_partition
 extern bool phantom_prot;
 
 // Primary-specific settings
@@ -79,8 +91,14 @@ extern int persist_policy;
 // CoroBase-specific settings
 extern bool index_probe_only;
 extern bool coro_tx;
-extern uint32_t coro_batch_size;
+extern uint32_t coro_workers;  // the first coro_workers workers use coroutines
+extern std::string coro_sequential_txns;  // types coroutine workers don't interleave
+extern uint32_t coro_batch_size;  // maximum depth if coro_adaptive_batch
 extern bool coro_batch_schedule;
+extern bool coro_adaptive_batch;
+extern uint32_t coro_min_batch_size;
+extern uint32_t coro_long_txn_interval;  // resume long txns every n rounds
+extern bool coro_batch_probe_cache;  // BATCH_SAME_TRX only
 
 extern bool scan_with_it;
 
@@ -1,9 +1,134 @@
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
 #include "sm-coroutine.h"
 
 namespace ermia {
 namespace coro {
 
+// All live allocators, for print_stats only
+static std::mutex tcalloc_registry_lock;
+static std::vector<tcalloc *> tcalloc_registry;
+
+tcalloc::tcalloc() : arena_top(nullptr), arena_end(nullptr) {
+  memset(entries, 0, sizeof(entries));
+  memset(stats, 0, sizeof(stats));
+  memset(&large_stats, 0, sizeof(large_stats));
+  node = numa_node_of_cpu(sched_getcpu());
+  add_chunk();
+
+  std::lock_guard<std::mutex> guard(tcalloc_registry_lock);
+  tcalloc_registry.push_back(this);
+}
+
+tcalloc::~tcalloc() {
+  {
+    std::lock_guard<std::mutex> guard(tcalloc_registry_lock);
+    for (auto it = tcalloc_registry.begin(); it != tcalloc_registry.end(); ++it) {
+      if (*it == this) {
+        tcalloc_registry.erase(it);
+        break;
+      }
+    }
+  }
+  for (auto *c : chunks) {
+    munmap(c, kChunkSize);
+  }
+}
+
+void tcalloc::add_chunk() {
+  // Over-map by a chunk so it can start on a huge page boundary, which THP
+  // needs; the madvise is best effort and normal pages are used if THP is off
+  uint8_t *p = static_cast<uint8_t *>(mmap(nullptr, 2 * kChunkSize, PROT_READ | PROT_WRITE,
+                                           MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+  LOG_IF(FATAL, p == MAP_FAILED) << "Unable to allocate coroutine frame chunk on node " << node
+                                 << ": " << strerror(errno);
+  uint8_t *chunk = reinterpret_cast<uint8_t *>(align_up(reinterpret_cast<uintptr_t>(p), kChunkSize));
+  if (chunk != p) {
+    munmap(p, chunk - p);
+  }
+  munmap(chunk + kChunkSize, p + kChunkSize - chunk);
+  madvise(chunk, kChunkSize, MADV_HUGEPAGE);
+  numa_tonode_memory(chunk, kChunkSize, node);
+  chunks.push_back(chunk);
+  arena_top = chunk;
+  arena_end = chunk + kChunkSize;
+}
+
+void *tcalloc::alloc_large(size_t byte_size) {
+  const size_t total = sizeof(FrameNode) + byte_size;
+  FrameNode *frame = static_cast<FrameNode *>(numa_alloc_onnode(total, node));
+  LOG_IF(FATAL, !frame) << "Unable to allocate coroutine frame of " << byte_size << " bytes";
+  frame->entry_index = kLargeEntry;
+  frame->size = total;
+  frame->chain = nullptr;
+#ifndef NDEBUG
+  frame->owner = this;
+#endif
+  large_stats.carved_bytes += total;
+  large_stats.live_bytes += total;
+  if (++large_stats.live > large_stats.peak) {
+    large_stats.peak = large_stats.live;
+  }
+  return static_cast<void *>(frame + 1);
+}
+
+void tcalloc::free_large(FrameNode *frame) {
+  large_stats.live_bytes -= frame->size;
+  --large_stats.live;
+  numa_free(frame, frame->size);
+}
+
+void tcalloc::print_stats(std::ostream &os) {
+  size_class_stats agg[kNumSizeClasses + 1];
+  memset(agg, 0, sizeof(agg));
+  size_t nchunks = 0;
+
+  std::lock_guard<std::mutex> guard(tcalloc_registry_lock);
+  for (auto *a : tcalloc_registry) {
+    for (uint32_t i = 0; i <= kNumSizeClasses; ++i) {
+      const size_class_stats &s = i < kNumSizeClasses ? a->stats[i] : a->large_stats;
+      agg[i].live += volatile_read(s.live);
+      agg[i].peak += volatile_read(s.peak);
+      agg[i].carved_bytes += volatile_read(s.carved_bytes);
+      agg[i].live_bytes += volatile_read(s.live_bytes);
+    }
+    nchunks += a->chunks.size();
+  }
+
+  os << "coroutine frames: " << tcalloc_registry.size() << " allocators, "
+     << nchunks << " chunks (" << nchunks * kChunkSize / 1024 / 1024 << "MB)" << std::endl;
+  for (uint32_t i = 0; i <= kNumSizeClasses; ++i) {
+    if (!agg[i].peak) {
+      continue;
+    }
+    if (i < kNumSizeClasses) {
+      os << "  " << (1UL << (i + kBeginSizeExp)) << "B";
+    } else {
+      os << "  large";
+    }
+    os << ": live " << agg[i].live << ", peak " << agg[i].peak
+       << ", live bytes " << agg[i].live_bytes << ", carved bytes " << agg[i].carved_bytes << std::endl;
+  }
+}
+
 thread_local tcalloc coroutine_allocator;
 
+chain_arena::chain_arena(size_t size) : high_water_(0) {
+  base_ = static_cast<uint8_t *>(numa_alloc_local(size));
+  LOG_IF(FATAL, !base_) << "Unable to allocate coroutine chain arena";
+  top_ = base_;
+  end_ = base_ + size;
+}
+
+chain_arena::~chain_arena() {
+  numa_free(base_, end_ - base_);
+}
+
+thread_local chain_arena *current_chain_arena = nullptr;
+
 } // namespace coro
 } // namespace ermia
@@ -3,6 +3,8 @@
 #include <experimental/coroutine>
 #include <array>
 #include <map>
+#include <ostream>
+#include <vector>
 #include <numa.h>
 
 #include "../macros.h"
@@ -11,26 +13,45 @@
 namespace ermia {
 namespace coro {
 
-// Simple thread caching allocator.
+// Simple thread caching allocator for coroutine frames.
+//
+// Frames are carved from NUMA-local chunks by bumping a pointer; a new
+// 2MB-aligned chunk, advised for transparent huge pages, is added whenever
+// the current one can't fit a frame. Freed frames are kept in per-size-class free lists.
+// Frames bigger than the largest size class go to numa_alloc_onnode
+// directly. In debug builds each frame remembers its owner so a free from
+// another thread is caught instead of silently polluting its free list.
 class tcalloc {
     struct alignas(CACHELINE_SIZE) FrameNode {
         FrameNode *next;
+#ifndef NDEBUG
+        tcalloc *owner;
+        uint64_t size;  // only meaningful for large frames
         uint8_t entry_index;
-        uint8_t padding[CACHELINE_SIZE - sizeof(intptr_t) - sizeof(uint8_t)];
+        uint8_t padding[CACHELINE_SIZE - 4 * sizeof(uint64_t) - sizeof(uint8_t)];
+#else
+        uint64_t size;  // only meaningful for large frames
+        uint8_t entry_index;
+        uint8_t padding[CACHELINE_SIZE - 3 * sizeof(uint64_t) - sizeof(uint8_t)];
+#endif
+        // Always nullptr; must be the last word, see chain_arena
+        void *chain;
     };
 
     static_assert(sizeof(FrameNode) == CACHELINE_SIZE, "");
 
    public:
-    tcalloc() { 
-        memset(entries, 0, sizeof(entries));
+    static constexpr size_t kChunkSize = 2 * 1024 * 1024;
 
-        constexpr size_t kArenaSize = 8 * 1024 * 1024;
-        arena = static_cast<uint8_t *>(
-            numa_alloc_onnode(kArenaSize, numa_node_of_cpu(sched_getcpu())));
-        arena_top = arena;
-    }
-    ~tcalloc() {}
+    struct size_class_stats {
+        uint64_t live;          // frames handed out and not freed yet
+        uint64_t peak;          // max of live
+        uint64_t carved_bytes;  // bytes ever taken from chunks (or the OS)
+        uint64_t live_bytes;    // bytes of the live frames
+    };
+
+    tcalloc();
+    ~tcalloc();
 
     static inline uint32_t lg_down(uint64_t x) {
         static_assert(sizeof(unsigned long long) * CHAR_BIT == 64, "");
@@ -47,18 +68,24 @@ class tcalloc {
         return lg_down(x - 1) + 1;
     }
 
-    void *alloc_from_arena(size_t byte_size, uint8_t alignment) {
+    inline void *alloc_from_arena(size_t byte_size, uint8_t alignment) {
         ASSERT(arena_top);
-        const int8_t mask = alignment - 1;
+        const intptr_t mask = alignment - 1;
         uint8_t *p = reinterpret_cast<uint8_t *>(
             reinterpret_cast<intptr_t>(arena_top + mask) & ~mask);
+        if (unlikely(p + byte_size > arena_end)) {
+            add_chunk();
+            p = arena_top;  // chunks are page aligned
+        }
         arena_top = p + byte_size;
         return reinterpret_cast<void *>(p);
     }
 
-    void *alloc(size_t byte_size) {
+    inline void *alloc(size_t byte_size) {
         const int ceil_log_2 = lg_up(byte_size);
-        ASSERT(ceil_log_2 < kEndSizeExp);
+        if (unlikely(ceil_log_2 >= kEndSizeExp)) {
+            return alloc_large(byte_size);
+        }
 
         const int entry_index =
             ceil_log_2 > kBeginSizeExp ? ceil_log_2 - kBeginSizeExp : 0;
@@ -69,31 +96,127 @@ class tcalloc {
             frame_to_alloc = reinterpret_cast<FrameNode *>(alloc_from_arena(
                 sizeof(FrameNode) + frame_size, CACHELINE_SIZE));
             frame_to_alloc->entry_index = entry_index;
+            frame_to_alloc->chain = nullptr;
+#ifndef NDEBUG
+            frame_to_alloc->owner = this;
+#endif
+            stats[entry_index].carved_bytes += sizeof(FrameNode) + frame_size;
         } else {
             entries[entry_index] = frame_to_alloc->next;
         }
 
+        size_class_stats &s = stats[entry_index];
+        s.live_bytes += sizeof(FrameNode) + (1 << (entry_index + kBeginSizeExp));
+        if (++s.live > s.peak) {
+            s.peak = s.live;
+        }
         return static_cast<void *>(frame_to_alloc + 1);
     }
 
-    void free(void *p, size_t byte_size) {
+    inline void free(void *p, size_t byte_size) {
         FrameNode *frame_to_free = reinterpret_cast<FrameNode *>(p) - 1;
+#ifndef NDEBUG
+        LOG_IF(FATAL, frame_to_free->owner != this)
+            << "Coroutine frame " << p << " freed by a thread that doesn't own it";
+#endif
         const int entry_index = frame_to_free->entry_index;
+        if (unlikely(entry_index == kLargeEntry)) {
+            free_large(frame_to_free);
+            return;
+        }
         frame_to_free->next = entries[entry_index];
         entries[entry_index] = frame_to_free;
+        --stats[entry_index].live;
+        stats[entry_index].live_bytes -= sizeof(FrameNode) + (1 << (entry_index + kBeginSizeExp));
     }
 
-   private:
+    inline const size_class_stats &get_stats(uint32_t entry_index) const {
+        ASSERT(entry_index < kNumSizeClasses);
+        return stats[entry_index];
+    }
+    inline const size_class_stats &get_large_stats() const { return large_stats; }
+    inline size_t get_nchunks() const { return chunks.size(); }
+
+    // Sum up the stats of all threads' allocators and print them
+    static void print_stats(std::ostream &os);
+
     static constexpr short kBeginSizeExp = 8;
-    static constexpr short kEndSizeExp = 16;  // exclusive
-    FrameNode *entries[kEndSizeExp - kBeginSizeExp];
+    static constexpr short kEndSizeExp = 21;  // exclusive, 1MB frames max
+    static constexpr uint32_t kNumSizeClasses = kEndSizeExp - kBeginSizeExp;
+
+   private:
+    static constexpr uint8_t kLargeEntry = 0xff;
+    static_assert((size_t{1} << (kEndSizeExp - 1)) + sizeof(FrameNode) <= kChunkSize,
+                  "Largest size class must fit in a chunk");
+
+    void add_chunk();
+    void *alloc_large(size_t byte_size);
+    void free_large(FrameNode *frame);
+
+    FrameNode *entries[kNumSizeClasses];
+    size_class_stats stats[kNumSizeClasses];
+    size_class_stats large_stats;
 
-    uint8_t *arena;
+    int node;
+    std::vector<uint8_t *> chunks;
     uint8_t *arena_top;
+    uint8_t *arena_end;
 };
 
 extern thread_local tcalloc coroutine_allocator;
 
+// Bump arena for all frames of one chain of task<T> coroutines, i.e., a
+// transaction's whole call tree. Frames are never freed one by one; the
+// owner reset()s the arena once the root task is done. The word right
+// before every frame points back to the arena (tcalloc frames have nullptr
+// there), which is how operator delete tells the two kinds apart.
+class chain_arena {
+   public:
+    static constexpr size_t kDefaultSize = 64 * 1024;
+
+    chain_arena(size_t size = kDefaultSize);
+    ~chain_arena();
+    chain_arena(const chain_arena &) = delete;
+    chain_arena &operator=(const chain_arena &) = delete;
+
+    // Returns nullptr if the arena is full, caller should fall back to tcalloc
+    inline void *alloc(size_t byte_size) {
+        const size_t total = (byte_size + 2 * kHeaderSize - 1) & ~(kHeaderSize - 1);
+        if (unlikely(top_ + total > end_)) {
+            return nullptr;
+        }
+        uint8_t *p = top_ + kHeaderSize;
+        reinterpret_cast<chain_arena **>(p)[-1] = this;
+        top_ += total;
+        return p;
+    }
+
+    inline void reset() {
+        if (used() > high_water_) {
+            high_water_ = used();
+        }
+        top_ = base_;
+    }
+
+    inline size_t used() const { return top_ - base_; }
+    inline size_t high_water() const { return high_water_; }
+
+    static inline bool is_chain_frame(void *p) {
+        return reinterpret_cast<chain_arena **>(p)[-1] != nullptr;
+    }
+
+   private:
+    static constexpr size_t kHeaderSize = 16;  // keeps frames 16-byte aligned
+
+    uint8_t *base_;
+    uint8_t *top_;
+    uint8_t *end_;
+    size_t high_water_;
+};
+
+// Arena of the task chain being resumed on this thread, if any
+extern thread_local chain_arena *current_chain_arena;
+
 template <typename T = void> struct [[nodiscard]] generator {
   struct promise_type;
   using handle = std::experimental::coroutine_handle<promise_type>;
@@ -237,7 +360,7 @@ private:
 // of the coroutine call stack.
 struct promise_base {
   promise_base()
-      : handle_(nullptr), parent_(nullptr), leaf_(nullptr), root_(nullptr) {}
+      : handle_(nullptr), parent_(nullptr), root_(nullptr), leaf_handle_(nullptr), arena_(nullptr) {}
   ~promise_base() {}
 
   promise_base(const promise_base &) = delete;
@@ -256,19 +379,30 @@ struct promise_base {
     }
     
     ASSERT(root_);
-    root_->leaf_ = parent_;
+    root_->leaf_handle_ = parent_->handle_;
     return coro_task_private::final_awaiter(
             parent_->get_coro_handle());
   }
   void unhandled_exception() { std::terminate(); }
 
-  // TODO: Use arena allocator. Probably one arena for
-  // each chain of coroutine task.
-  // It is very important to use arena to reduce the
-  // cache miss in access promise_base * which happens
-  // a lot in task<T>.resume();
-  void *operator new(size_t sz) { return coroutine_allocator.alloc(sz); }
-  void operator delete(void *p, size_t sz) { coroutine_allocator.free(p, sz); }
+  // Frames of a chain being resumed with an arena come from that arena,
+  // everything else (including the root frame) from tcalloc.
+  void *operator new(size_t sz) {
+    chain_arena *arena = current_chain_arena;
+    if (arena) {
+      void *p = arena->alloc(sz);
+      if (p) {
+        return p;
+      }
+    }
+    return coroutine_allocator.alloc(sz);
+  }
+  void operator delete(void *p, size_t sz) {
+    // Chain arena frames go away with chain_arena::reset()
+    if (!chain_arena::is_chain_frame(p)) {
+      coroutine_allocator.free(p, sz);
+    }
+  }
 
   inline void set_parent(promise_base * caller_promise) {
       parent_ = caller_promise;
@@ -277,17 +411,23 @@ struct promise_base {
       root_ = parent_->root_;
 
       ASSERT(root_);
-      root_->leaf_ = this;
+      root_->leaf_handle_ = handle_;
   }
 
-  inline promise_base *get_leaf() const {
-      ASSERT(leaf_);
-      return leaf_;
+  // Only valid on the root: handle of the innermost coroutine to resume,
+  // kept here so resuming doesn't need to chase the leaf's promise.
+  inline generic_coroutine_handle get_leaf_handle() const {
+      ASSERT(root_ == this);
+      ASSERT(leaf_handle_);
+      return leaf_handle_;
   }
 
-  inline void set_as_root() {
-      leaf_ = this;
+  inline chain_arena *get_chain_arena() const { return arena_; }
+
+  inline void set_as_root(chain_arena *arena) {
+      leaf_handle_ = handle_;
       root_ = this;
+      arena_ = arena;
   }
 
   inline generic_coroutine_handle get_coro_handle() const {
@@ -297,8 +437,9 @@ struct promise_base {
 protected:
   generic_coroutine_handle handle_;
   promise_base * parent_;
-  promise_base * leaf_;
   promise_base * root_;
+  generic_coroutine_handle leaf_handle_;  // root only
+  chain_arena * arena_;                   // root only
 };
 
 } // namespace coro_task_private
@@ -343,21 +484,21 @@ public:
     return coroutine_.done();
   }
 
-  void start() {
+  // Start the chain rooted at this task. With an [arena], all nested
+  // frames of the chain are bump-allocated from it; the caller resets it
+  // after the task is done and destroyed.
+  void start(chain_arena *arena = nullptr) {
     ASSERT(coroutine_);
     ASSERT(!coroutine_.done());
-    coroutine_.promise().set_as_root();
-    coroutine_.resume();
+    coroutine_.promise().set_as_root(arena);
+    run(coroutine_);
   }
 
   void resume() {
     ASSERT(coroutine_);
     ASSERT(!coroutine_.done());
-    ASSERT(coroutine_.promise().get_leaf());
-    ASSERT(coroutine_.promise().get_leaf()->get_coro_handle());
-    ASSERT(!coroutine_.promise().get_leaf()->get_coro_handle().done());
-
-    coroutine_.promise().get_leaf()->get_coro_handle().resume();
+    ASSERT(!coroutine_.promise().get_leaf_handle().done());
+    run(coroutine_.promise().get_leaf_handle());
   }
 
   void destroy() {
@@ -378,6 +519,18 @@ public:
   }
 
 private:
+  inline void run(coro_task_private::generic_coroutine_handle h) {
+    chain_arena *arena = coroutine_.promise().get_chain_arena();
+    if (arena) {
+      chain_arena *prev = current_chain_arena;
+      current_chain_arena = arena;
+      h.resume();
+      current_chain_arena = prev;
+    } else {
+      h.resume();
+    }
+  }
+
   coroutine_handle coroutine_;
 };
 
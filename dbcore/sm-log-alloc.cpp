@@ -2,6 +2,7 @@
 #include "sm-cmd-log.h"
 #include "sm-log-alloc.h"
 #include "sm-rep.h"
+#include "sm-thread.h"
 #include "stopwatch.h"
 #include "../util.h"
 
@@ -14,6 +15,7 @@ uint64_t get_starting_byte_offset(ermia::sm_log_recover_mgr *lm) {
 }
 
 extern "C" void *log_write_daemon_thunk(void *arg) {
+  ermia::thread::PinDaemon(ermia::thread::kDaemonLog);
   ((ermia::sm_log_alloc_mgr *)arg)->_log_write_daemon();
   return NULL;
 }
@@ -56,8 +58,8 @@ sm_log_alloc_mgr::sm_log_alloc_mgr(sm_log_recover_impl *rf, void *rfn_arg)
   _logbuf->_head = _logbuf->_tail = get_starting_byte_offset(&_lm);
   if (!config::is_backup_srv() || (config::command_log && config::replay_threads)) {
     _tls_lsn_offset =
-        (uint64_t *)malloc(sizeof(uint64_t) * config::MAX_THREADS);
-    memset(_tls_lsn_offset, 0, sizeof(uint64_t) * config::MAX_THREADS);
+        (uint64_t *)malloc(sizeof(uint64_t) * config::max_threads);
+    memset(_tls_lsn_offset, 0, sizeof(uint64_t) * config::max_threads);
 
     uint32_t n = config::is_backup_srv() ? config::replay_threads : config::worker_threads;
     _commit_queue = new commit_queue[n];
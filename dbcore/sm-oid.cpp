@@ -1,7 +1,12 @@
 #include <fcntl.h>
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
 #include <unistd.h>
 
 #include <map>
+#include <mutex>
+#include <vector>
 
 #include "../ermia.h"
 #include "../txn.h"
@@ -146,10 +151,62 @@ thread_data::cache_map::iterator thread_cache(sm_oid_mgr_impl *om, FID f) {
   return rval.first;
 }
 
+/* Fill [tc] from the calling thread's node's extent of [f], claiming a
+   new extent from the allocator when it runs out. OIDs freed back to the
+   allocator are still recycled first, as long as they can fill the cache.
+ */
+void partition_fill_cache(sm_oid_mgr_impl *om, FID f, oid_array *oa,
+                          sm_allocator::thread_cache *tc) {
+  static thread_local int my_node = -1;
+  if (unlikely(my_node < 0)) {
+    my_node = numa_node_of_cpu(sched_getcpu());
+    ALWAYS_ASSERT(my_node >= 0 && my_node < (int)config::kMaxNumaNodes);
+  }
+
+  om->lock_file(f);
+  DEFER(om->unlock_file(f));
+  auto *alloc = om->get_allocator(f);
+  if (alloc->head.l1_size >= sm_allocator::thread_cache::FILL_TARGET) {
+    alloc->fill_cache(tc);
+    return;
+  }
+
+  auto &cur = oa->_partition->cursors[my_node];
+  for (size_t n = 0; n < sm_allocator::thread_cache::FILL_TARGET; ++n) {
+    if (cur.next == cur.end) {
+      // Claim the rest of the extent the allocator's bump pointer is in
+      OID begin = alloc->head.hiwater_mark;
+      OID end = align_up(begin + 1, OID(1) << oid_partition::kExtentBits);
+      while (alloc->head.capacity_mark < end) {
+        auto cbump = alloc->propose_capacity(1);
+        LOG_IF(FATAL, not cbump) << "OID array " << f << " is full";
+        alloc->head.capacity_mark = cbump;
+      }
+      oa->ensure_size(alloc->head.capacity_mark);
+      alloc->head.hiwater_mark = end;
+      // A partial extent (the bump pointer was mid-extent, e.g., after
+      // recovery) also holds OIDs other nodes allocated, so it stays kNoNode
+      if (begin == align_down(begin, OID(1) << oid_partition::kExtentBits)) {
+        oa->_partition->extent_nodes[begin >> oid_partition::kExtentBits] = my_node;
+      }
+      oa->bind_to_node(begin, end, my_node);
+      cur.next = begin;
+      cur.end = end;
+    }
+    tc->entries[tc->nentries++] = cur.next++;
+  }
+}
+
 OID thread_allocate(sm_oid_mgr_impl *om, FID f) {
   // correct cache entry definitely exists now... but may be empty
   auto it = thread_cache(om, f);
   ASSERT(it->f == f);
+  if (not it->nentries && config::oid_numa_partition) {
+    oid_array *oa = om->get_array(f);
+    if (oa->_partition) {
+      partition_fill_cache(om, f, oa, &*it);
+    }
+  }
   if (not it->nentries) {
     om->lock_file(f);
     DEFER(om->unlock_file(f));
@@ -190,12 +247,83 @@ fat_ptr oid_array::make() {
   return fat_ptr::make(rval, 1);
 }
 
-void oid_array::destroy(oid_array *oa) { oa->~oid_array(); }
+void oid_array::destroy(oid_array *oa) {
+  if (oa->_partition) {
+    free(oa->_partition);
+  }
+  oa->~oid_array();
+}
 
-oid_array::oid_array(dynarray &&self) : _backing_store(std::move(self)) {
+oid_array::oid_array(dynarray &&self)
+    : _backing_store(std::move(self)),
+      _partition(config::oid_numa_partition ? oid_partition::make() : nullptr) {
   ASSERT(this == (void *)_backing_store.data());
 }
 
+void oid_array::bind_to_node(OID begin, OID end, int node) {
+  // Round inwards: pages shared with a neighbouring extent stay put
+  auto page = sysconf(_SC_PAGESIZE);
+  char *from = (char *)align_up((uintptr_t)&_entries[begin], page);
+  char *to = (char *)align_down((uintptr_t)&_entries[end], page);
+  if (from >= to) {
+    return;
+  }
+  struct bitmask *mask = numa_bitmask_alloc(numa_num_possible_nodes());
+  numa_bitmask_setbit(mask, node);
+  long err = mbind(from, to - from, MPOL_BIND, mask->maskp, mask->size + 1, MPOL_MF_MOVE);
+  numa_bitmask_free(mask);
+  LOG_IF(WARNING, err) << "Unable to bind OIDs " << begin << "-" << end << " to node "
+                       << node << ": " << strerror(errno);
+}
+
+size_t oid_partition::nextents() {
+  return (oid_array::MAX_ENTRIES >> kExtentBits) + 1;
+}
+
+oid_partition *oid_partition::make() {
+  size_t size = sizeof(oid_partition) + nextents();
+  auto *p = (oid_partition *)malloc(size);
+  LOG_IF(FATAL, !p) << "Unable to allocate OID partition";
+  memset(p->cursors, 0, sizeof(p->cursors));
+  memset(p->extent_nodes, kNoNode, nextents());
+  return p;
+}
+
+thread_local oid_access_stats *tls_oid_access_stats = nullptr;
+static std::mutex oid_access_stats_lock;
+static std::vector<oid_access_stats *> oid_access_stats_registry;
+
+oid_access_stats *register_oid_access_stats() {
+  auto *s = new oid_access_stats;
+  memset(s, 0, sizeof(*s));
+  s->my_node = numa_node_of_cpu(sched_getcpu());
+  std::lock_guard<std::mutex> guard(oid_access_stats_lock);
+  oid_access_stats_registry.push_back(s);
+  tls_oid_access_stats = s;
+  return s;
+}
+
+void oid_access_stats::print(std::ostream &os) {
+  uint64_t by_node[config::kMaxNumaNodes];
+  memset(by_node, 0, sizeof(by_node));
+  uint64_t total = 0, remote = 0;
+  std::lock_guard<std::mutex> guard(oid_access_stats_lock);
+  for (auto *s : oid_access_stats_registry) {
+    for (uint32_t i = 0; i < config::kMaxNumaNodes; ++i) {
+      by_node[i] += volatile_read(s->by_node[i]);
+      total += volatile_read(s->by_node[i]);
+    }
+    remote += volatile_read(s->remote);
+  }
+  os << "oid_entry_accesses_by_node:";
+  for (uint32_t i = 0; i < config::kMaxNumaNodes; ++i) {
+    if (by_node[i]) {
+      os << " " << i << "=" << by_node[i];
+    }
+  }
+  os << " (" << (total ? 100.0 * remote / total : 0) << "% remote)" << std::endl;
+}
+
 void oid_array::ensure_size(size_t n) {
   _backing_store.ensure_size(OFFSETOF(oid_array, _entries[n]));
 }
@@ -1031,6 +1159,7 @@ void sm_oid_mgr::oid_get_version_amac(oid_array *oa,
 // For tuple arrays only, i.e., entries are guaranteed to point to Objects.
 PROMISE(dbtuple *) sm_oid_mgr::oid_get_version(oid_array *oa, OID o,
                                      TXN::xid_context *visitor_xc) {
+  oa->count_access(o);
   fat_ptr *entry = oa->get(o);
 start_over:
   fat_ptr ptr = volatile_read(*entry);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ostream>
+
 #include "epoch.h"
 #include "sm-common.h"
 #include "sm-oid-alloc-impl.h"
@@ -23,6 +25,44 @@ typedef epoch_mgr::epoch_num epoch_num;
  */
 static size_t const SZCODE_ALIGN_BITS = dynarray::page_bits();
 
+/* With --oid_numa_partition, an OID array is carved into extents of
+   2^kExtentBits OIDs. A node claims a whole extent at a time from the
+   file's allocator, binds the extent's entries to itself and hands out
+   its OIDs to threads on that node only, so a table's indirection
+   entries live on the node that inserted the records.
+ */
+struct oid_partition {
+  static uint32_t const kExtentBits = 16;
+  static uint8_t const kNoNode = 0xff;  // not claimed through a partition
+
+  /* The unused part of the extent a node currently allocates from.
+     Protected by the file's mutex in sm_oid_mgr_impl.
+   */
+  struct cursor {
+    OID next;
+    OID end;
+  };
+
+  cursor cursors[config::kMaxNumaNodes];
+  uint8_t extent_nodes[];  // home node of each wholly claimed extent
+
+  static oid_partition *make();
+  static size_t nextents();
+};
+
+/* Per-thread counts of OID entry accesses, by the home node of the
+   entry. Only counted for partitioned arrays.
+ */
+struct oid_access_stats {
+  uint64_t by_node[config::kMaxNumaNodes];
+  uint64_t remote;
+  int my_node;  // node of the owning thread
+
+  static void print(std::ostream &os);
+};
+extern thread_local oid_access_stats *tls_oid_access_stats;
+oid_access_stats *register_oid_access_stats();
+
 /* An OID is essentially an array of fat_ptr. The only bit of
    magic is that it embeds the dynarray that manages the storage
    it occupies.
@@ -30,7 +70,8 @@ static size_t const SZCODE_ALIGN_BITS = dynarray::page_bits();
 struct oid_array {
   static size_t const MAX_SIZE = sizeof(fat_ptr) << 32;
   static uint64_t const MAX_ENTRIES =
-      (size_t(1) << 32) - sizeof(dynarray) / sizeof(fat_ptr);
+      (size_t(1) << 32) -
+      (sizeof(dynarray) + sizeof(oid_partition *)) / sizeof(fat_ptr);
   static size_t const ENTRIES_PER_PAGE =
       (sizeof(fat_ptr) << SZCODE_ALIGN_BITS) / 2;
 
@@ -74,7 +115,29 @@ struct oid_array {
    */
   fat_ptr *get(OID o) { return &_entries[o]; }
 
+  /* Bind the entries of OIDs [begin, end) to [node], moving pages that
+     were already faulted in elsewhere. Only whole pages are bound.
+   */
+  void bind_to_node(OID begin, OID end, int node);
+
+  /* Count an access to [o]'s entry against the node it lives on.
+   */
+  inline void count_access(OID o) {
+    if (_partition) {
+      auto node = _partition->extent_nodes[o >> oid_partition::kExtentBits];
+      if (node != oid_partition::kNoNode) {
+        auto *s = tls_oid_access_stats;
+        if (unlikely(!s)) {
+          s = register_oid_access_stats();
+        }
+        ++s->by_node[node];
+        s->remote += (node != s->my_node);
+      }
+    }
+  }
+
   dynarray _backing_store;
+  oid_partition *_partition;  // nullptr unless --oid_numa_partition
   fat_ptr _entries[];
 };
 
@@ -35,9 +35,9 @@ struct rc_t {
   rc_t() : _val(RC_INVALID) {}
   rc_t(uint16_t v) : _val(v) {}
 
-  inline bool IsUserAbort() { return _val == RC_ABORT_USER; }
-  inline bool IsInvalid() { return _val == RC_INVALID; }
-  inline bool IsAbort() { return _val & RC_ABORT; }
+  inline bool IsUserAbort() const { return _val == RC_ABORT_USER; }
+  inline bool IsInvalid() const { return _val == RC_INVALID; }
+  inline bool IsAbort() const { return _val & RC_ABORT; }
 };
 
 
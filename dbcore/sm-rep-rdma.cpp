@@ -2,6 +2,7 @@
 #include "rcu.h"
 #include "sm-rep.h"
 #include "sm-rep-rdma.h"
+#include "sm-thread.h"
 #include "../ermia.h"
 
 namespace ermia {
@@ -90,6 +91,7 @@ void bring_up_backup_rdma(RdmaNode* rn, int chkpt_fd,
 // the latest chkpt (if any) + the log that follows (if any). Uses RDMA
 // based memcpy to transfer chkpt and log file data.
 void primary_daemon_rdma() {
+  thread::PinDaemon(thread::kDaemonReplication);
   // Create an RdmaNode object for each backup node
   std::vector<std::thread*> workers;
   for (uint32_t i = 0; i < config::num_backups; ++i) {
@@ -279,6 +281,7 @@ LSN BackupReceiveLogData(LSN& start_lsn, uint64_t &size) {
 }
 
 void BackupDaemonRdma() {
+  thread::PinDaemon(thread::kDaemonReplication);
   ALWAYS_ASSERT(logmgr);
   RCU::rcu_register();
   DEFER(RCU::rcu_deregister());
@@ -4,6 +4,7 @@
 #include "sm-cmd-log.h"
 #include "sm-log-file.h"
 #include "sm-rep.h"
+#include "sm-thread.h"
 #include "../ermia.h"
 
 namespace ermia {
@@ -47,6 +48,7 @@ void bring_up_backup_tcp(int backup_sockfd, backup_start_metadata *md) {
 // A daemon that runs on the primary for bringing up backups by shipping
 // the latest chkpt (if any) + the log that follows (if any).
 void primary_daemon_tcp() {
+  thread::PinDaemon(thread::kDaemonReplication);
   ALWAYS_ASSERT(logmgr);
   tcp::server_context primary_tcp_ctx(config::primary_port,
                                       config::num_backups);
@@ -256,6 +258,7 @@ void BackupReceiveBoundsArrayTcp(ReplayPipelineStage& pipeline_stage) {
 }
 
 void BackupDaemonTcp() {
+  thread::PinDaemon(thread::kDaemonReplication);
   ALWAYS_ASSERT(logmgr);
   RCU::rcu_register();
   DEFER(RCU::rcu_deregister());
@@ -369,6 +372,7 @@ void PrimaryShutdownTcp() {
 }
 
 void BackupDaemonTcpCommandLog() {
+  thread::PinDaemon(thread::kDaemonReplication);
   ALWAYS_ASSERT(CommandLog::cmd_log);
   ALWAYS_ASSERT(cctx);
   RCU::rcu_register();
@@ -1,6 +1,7 @@
 #include "rcu.h"
 #include "sm-cmd-log.h"
 #include "sm-rep.h"
+#include "sm-thread.h"
 #include "../ermia.h"
 
 namespace ermia {
@@ -41,6 +42,7 @@ void start_as_primary() {
 }
 
 void LogFlushDaemon() {
+  thread::PinDaemon(thread::kDaemonLog);
   new_end_lsn_offset = 0;
   RCU::rcu_register();
   DEFER(RCU::rcu_deregister());
@@ -64,6 +66,7 @@ void LogFlushDaemon() {
 
 // Daemon for shipping log out of the commit path (ie async log shipping)
 void PrimaryAsyncShippingDaemon() {
+  thread::PinDaemon(thread::kDaemonReplication);
   ALWAYS_ASSERT(config::persist_policy == config::kPersistAsync);
   uint64_t start_offset = logmgr->durable_flushed_lsn().offset();
   // FIXME(tzwang): support segment boundary crossing
@@ -98,6 +101,7 @@ void PrimaryAsyncShippingDaemon() {
 
 // The major routine that controls background async replay
 void BackupBackgroundReplay() {
+  thread::PinDaemon(thread::kDaemonReplication);
   LOG_IF(FATAL, config::command_log);
   RCU::rcu_register();
   DEFER(RCU::rcu_deregister());
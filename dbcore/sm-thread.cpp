@@ -1,3 +1,8 @@
+#include <sched.h>
+
+#include <algorithm>
+#include <sstream>
+
 #include "rcu.h"
 #include "serial.h"
 #include "sm-alloc.h"
@@ -11,9 +16,22 @@ std::atomic<uint32_t> next_thread_id(0);
 PerNodeThreadPool *thread_pools = nullptr;
 thread_local bool thread_initialized CACHE_ALIGNED;
 uint32_t PerNodeThreadPool::max_threads_per_node = 0;
+uint32_t PerNodeThreadPool::bitmap_words = 0;
 uint32_t num_thread_pools = 0;
 
 std::vector<CPUCore> cpu_cores;
+
+// Read a single integer from /sys/devices/system/cpu/cpuX/[file], -1 if
+// it's not there (e.g., no L3 or no topology info in VMs)
+static int32_t ReadCPUValue(uint32_t cpu, const char *file) {
+  std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/" + file);
+  int32_t v = -1;
+  if (f.good()) {
+    f >> v;
+  }
+  return f.fail() ? -1 : v;
+}
+
 bool DetectCPUCores() {
   // FIXME(tzwang): Linux-specific way of querying NUMA topology
   //
@@ -60,6 +78,8 @@ bool DetectCPUCores() {
       // A physical core?
       if (cpu == threads[0]) {
         cpu_cores.emplace_back(node, threads[0]);
+        cpu_cores.back().socket = std::max(ReadCPUValue(cpu, "topology/physical_package_id"), 0);
+        cpu_cores.back().llc = ReadCPUValue(cpu, "cache/index3/id");
         for (uint32_t i = 1; i < threads.size(); ++i) {
           cpu_cores[cpu_cores.size()-1].AddLogical(threads[i]);
         }
@@ -80,9 +100,14 @@ Thread::Thread()
       sys_cpu(0),
       shutdown(false),
       state(kStateNoWork),
+      join_waiters(0),
       task(nullptr),
       sleep_when_idle(true),
-      is_physical(false) {
+      is_physical(false),
+      join_spin_cycles(0),
+      join_blocks(0),
+      idle_spin_cycles(0),
+      idle_blocks(0) {
   // Only allowed when not using thread pool
   ALWAYS_ASSERT(!config::threadpool);
 
@@ -97,9 +122,14 @@ Thread::Thread(uint16_t n, uint16_t c, uint32_t sys_cpu, bool is_physical)
       sys_cpu(sys_cpu),
       shutdown(false),
       state(kStateNoWork),
+      join_waiters(0),
       task(nullptr),
       sleep_when_idle(true),
-      is_physical(is_physical) {
+      is_physical(is_physical),
+      join_spin_cycles(0),
+      join_blocks(0),
+      idle_spin_cycles(0),
+      idle_blocks(0) {
   int rc = pthread_attr_init (&thd_attr);
   pthread_create(&thd, &thd_attr, &Thread::StaticIdleTask, (void *)this);
   cpu_set_t cpuset;
@@ -110,39 +140,247 @@ Thread::Thread(uint16_t n, uint16_t c, uint32_t sys_cpu, bool is_physical)
   ALWAYS_ASSERT(rc == 0);
 }
 
-PerNodeThreadPool::PerNodeThreadPool(uint16_t n) : node(n), bitmap(0UL) {
+static const char *kDaemonNames[kNumDaemonClasses] = {"log", "commit", "chkpt", "rep"};
+
+struct DaemonPlacement {
+  bool pinned;
+  int32_t core;  // index into cpu_cores for core:N, -1 for node:N
+  int32_t node;
+  cpu_set_t cpus;
+};
+static DaemonPlacement daemon_placements[kNumDaemonClasses];
+
+// Daemon class that owns each entry of cpu_cores, -1 for the thread pool
+static std::vector<int32_t> core_owner;
+
+static void PlaceOnNode(DaemonClass cls, uint32_t node) {
+  auto &p = daemon_placements[cls];
+  p.pinned = true;
+  p.core = -1;
+  p.node = node;
+  CPU_ZERO(&p.cpus);
+  for (auto &c : cpu_cores) {
+    if (c.node == node) {
+      CPU_SET(c.physical_thread, &p.cpus);
+      for (auto sib : c.logical_threads) {
+        CPU_SET(sib, &p.cpus);
+      }
+    }
+  }
+}
+
+static void PlaceOnCore(DaemonClass cls, uint32_t node) {
+  // Take cores from the end of the node so workers (which fill the pool
+  // from the front) keep the low ones. Once a node has given a core to a
+  // daemon, try to keep its other daemons in the same LLC domain.
+  int32_t llc = -1;
+  uint32_t free_cores = 0;
+  for (uint32_t i = 0; i < cpu_cores.size(); ++i) {
+    if (cpu_cores[i].node == node) {
+      if (core_owner[i] >= 0) {
+        llc = cpu_cores[i].llc;
+      } else {
+        ++free_cores;
+      }
+    }
+  }
+  if (free_cores <= 1) {
+    LOG(WARNING) << "Node " << node << " has no core to spare for " << kDaemonNames[cls]
+                 << ", placing it on the whole node";
+    PlaceOnNode(cls, node);
+    return;
+  }
+
+  int32_t pick = -1;
+  for (int32_t i = cpu_cores.size() - 1; i >= 0; --i) {
+    if (cpu_cores[i].node != node || core_owner[i] >= 0) {
+      continue;
+    }
+    if (pick < 0) {
+      pick = i;
+    }
+    if (llc < 0 || cpu_cores[i].llc == llc) {
+      pick = i;
+      break;
+    }
+  }
+  ALWAYS_ASSERT(pick >= 0);
+  core_owner[pick] = cls;
+
+  auto &p = daemon_placements[cls];
+  auto &c = cpu_cores[pick];
+  p.pinned = true;
+  p.core = pick;
+  p.node = node;
+  CPU_ZERO(&p.cpus);
+  CPU_SET(c.physical_thread, &p.cpus);
+  for (auto sib : c.logical_threads) {
+    CPU_SET(sib, &p.cpus);
+  }
+}
+
+void ApplyPlacementPolicy() {
+  core_owner.assign(cpu_cores.size(), -1);
+  memset(daemon_placements, 0, sizeof(daemon_placements));
+
+  std::stringstream ss(config::placement_policy);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty()) {
+      continue;
+    }
+    auto eq = item.find('=');
+    LOG_IF(FATAL, eq == std::string::npos) << "Invalid placement: " << item;
+    std::string cls_name = item.substr(0, eq);
+    std::string rule = item.substr(eq + 1);
+
+    if (cls_name == "workers") {
+      LOG_IF(FATAL, rule != "compact" && rule != "spread") << "Invalid worker placement: " << rule;
+      config::numa_spread = (rule == "spread");
+      continue;
+    }
+
+    int32_t cls = -1;
+    for (uint32_t i = 0; i < kNumDaemonClasses; ++i) {
+      if (cls_name == kDaemonNames[i]) {
+        cls = i;
+      }
+    }
+    LOG_IF(FATAL, cls < 0) << "Unknown thread class in placement: " << cls_name;
+    if (rule == "none") {
+      daemon_placements[cls].pinned = false;
+      continue;
+    }
+
+    auto colon = rule.find(':');
+    LOG_IF(FATAL, colon == std::string::npos) << "Invalid placement rule: " << rule;
+    uint32_t node = std::stoul(rule.substr(colon + 1));
+    LOG_IF(FATAL, node > (uint32_t)numa_max_node()) << "No node " << node;
+    std::string kind = rule.substr(0, colon);
+    if (kind == "core") {
+      LOG_IF(FATAL, !config::threadpool) << "core:N placement needs the thread pool";
+      PlaceOnCore((DaemonClass)cls, node);
+    } else if (kind == "node") {
+      PlaceOnNode((DaemonClass)cls, node);
+    } else {
+      LOG(FATAL) << "Invalid placement rule: " << rule;
+    }
+  }
+
+  uint32_t pool_cores = 0;
+  for (auto owner : core_owner) {
+    pool_cores += (owner < 0);
+  }
+  LOG_IF(WARNING, config::worker_threads > pool_cores && config::physical_workers_only)
+      << "Only " << pool_cores << " physical cores left for " << config::worker_threads
+      << " workers";
+}
+
+void PinDaemon(DaemonClass cls) {
+  auto &p = daemon_placements[cls];
+  if (!p.pinned) {
+    return;
+  }
+  int rc = sched_setaffinity(0, sizeof(cpu_set_t), &p.cpus);
+  LOG_IF(WARNING, rc) << "Unable to pin " << kDaemonNames[cls] << " daemon: " << strerror(errno);
+  LOG(INFO) << "Pinned " << kDaemonNames[cls] << " daemon to "
+            << (p.core >= 0 ? "core " + std::to_string(cpu_cores[p.core].physical_thread) : "node")
+            << " on node " << p.node;
+}
+
+void PrintPlacement(std::ostream &os) {
+  os << "  placement:" << std::endl;
+  os << "    workers: " << (config::numa_spread ? "spread" : "compact") << " over "
+     << config::numa_nodes << " node(s)" << std::endl;
+  for (uint32_t i = 0; i < kNumDaemonClasses; ++i) {
+    auto &p = daemon_placements[i];
+    os << "    " << kDaemonNames[i] << ": ";
+    if (!p.pinned) {
+      os << "unpinned";
+    } else if (p.core >= 0) {
+      os << "core " << cpu_cores[p.core].physical_thread << " on node " << p.node;
+    } else {
+      os << "node " << p.node;
+    }
+    os << std::endl;
+  }
+  for (uint32_t i = 0; i < cpu_cores.size(); ++i) {
+    auto &c = cpu_cores[i];
+    os << "    core " << c.physical_thread << ": socket " << c.socket << ", node " << c.node
+       << ", llc " << c.llc << ", cpus " << c.physical_thread;
+    for (auto sib : c.logical_threads) {
+      os << "," << sib;
+    }
+    int32_t owner = core_owner.size() ? core_owner[i] : -1;
+    os << " -> " << (owner >= 0 ? kDaemonNames[owner] : (config::threadpool ? "pool" : "os"))
+       << std::endl;
+  }
+}
+
+PerNodeThreadPool::PerNodeThreadPool(uint16_t n) : node(n), nthreads(0), bitmap(nullptr) {
   ALWAYS_ASSERT(!numa_run_on_node(node));
   threads = (Thread *)numa_alloc_onnode(
       sizeof(Thread) * max_threads_per_node, node);
+  bitmap = (uint64_t *)numa_alloc_onnode(sizeof(uint64_t) * bitmap_words, node);
+  LOG_IF(FATAL, !threads || !bitmap) << "Unable to allocate thread pool on node " << n;
+  memset(bitmap, 0, sizeof(uint64_t) * bitmap_words);
 
-  if (cpu_cores.size()) {
-    uint32_t total_numa_nodes = numa_max_node() + 1;
-    ALWAYS_ASSERT(cpu_cores.size() / total_numa_nodes <= max_threads_per_node);
-    LOG(INFO) << "Node " << n << " has " << cpu_cores.size() / total_numa_nodes
-              << " physical cores, " << max_threads_per_node
-              << " threads"; uint32_t core = 0;
-    for (uint32_t i = 0; i < cpu_cores.size(); ++i) {
-      auto &c = cpu_cores[i];
-      if (c.node == n) {
-        uint32_t sys_cpu = c.physical_thread;
-        new (threads + core) Thread(node, core, sys_cpu, true);
-        for (auto &sib : c.logical_threads) {
-          ++core;
-          new (threads + core) Thread(node, core, sib, false);
-        }
+  // Threads beyond what this node has stay marked busy so they are never
+  // handed out (nodes may have different numbers of cores)
+  uint32_t core = 0;
+  uint32_t physical = 0;
+  for (uint32_t i = 0; i < cpu_cores.size(); ++i) {
+    auto &c = cpu_cores[i];
+    if (c.node == n) {
+      ALWAYS_ASSERT(core + 1 + c.logical_threads.size() <= max_threads_per_node);
+      // Cores the placement policy gave to a daemon are never handed out
+      bool reserved = core_owner.size() && core_owner[i] >= 0;
+      uint32_t sys_cpu = c.physical_thread;
+      new (threads + core) Thread(node, core, sys_cpu, true);
+      if (reserved) {
+        bitmap[core / 64] |= (1UL << (core % 64));
+      }
+      for (auto &sib : c.logical_threads) {
         ++core;
+        new (threads + core) Thread(node, core, sib, false);
+        if (reserved) {
+          bitmap[core / 64] |= (1UL << (core % 64));
+        }
       }
+      ++core;
+      ++physical;
     }
   }
+  nthreads = core;
+  for (uint32_t pos = core; pos < bitmap_words * 64; ++pos) {
+    bitmap[pos / 64] |= (1UL << (pos % 64));
+  }
+  LOG(INFO) << "Node " << n << " has " << physical << " physical cores, " << core
+            << " threads";
 }
 
 void Initialize() {
   bool detected = thread::DetectCPUCores();
   LOG_IF(FATAL, !detected);
+  ApplyPlacementPolicy();
+
+  // Size everything per-thread from the topology: one ID per hardware thread
+  // for workers plus headroom for the main thread, log/GC/checkpoint daemons
+  // and non-pool threads, which also take IDs.
+  config::max_threads = std::max<uint32_t>(std::thread::hardware_concurrency() * 2, 96);
 
   if (config::threadpool) {
     num_thread_pools = numa_max_node() + 1;
-    PerNodeThreadPool::max_threads_per_node = std::thread::hardware_concurrency() / num_thread_pools;
+    std::vector<uint32_t> node_threads(num_thread_pools, 0);
+    for (auto &c : cpu_cores) {
+      node_threads[c.node] += 1 + c.logical_threads.size();
+    }
+    PerNodeThreadPool::max_threads_per_node =
+        std::max<uint32_t>(*std::max_element(node_threads.begin(), node_threads.end()), 1);
+    PerNodeThreadPool::bitmap_words = (PerNodeThreadPool::max_threads_per_node + 63) / 64;
+    LOG(INFO) << "Thread pool: " << num_thread_pools << " nodes, up to "
+              << PerNodeThreadPool::max_threads_per_node << " threads per node, "
+              << config::max_threads << " thread IDs";
     thread_pools =
         (PerNodeThreadPool *)malloc(sizeof(PerNodeThreadPool) * num_thread_pools);
     for (uint16_t i = 0; i < num_thread_pools; i++) {
@@ -151,9 +389,35 @@ void Initialize() {
   }
 }
 
-void Thread::IdleTask() {
-  std::unique_lock<std::mutex> lock(trigger_lock);
+void Thread::Join() {
+  if (volatile_read(state) != kStateHasWork) {
+    return;
+  }
 
+  // Spin for a bounded time first: most tasks we join (log flushes, replay
+  // batches) finish shortly
+  uint64_t start = __rdtsc();
+  uint64_t now = start;
+  while (volatile_read(state) == kStateHasWork && now - start < kSpinCycles) {
+    NOP_PAUSE;
+    now = __rdtsc();
+  }
+  __sync_fetch_and_add(&join_spin_cycles, now - start);
+
+  // Then block until IdleTask flips the state and wakes us up. Registering in
+  // join_waiters before re-checking state pairs with IdleTask storing the
+  // state before checking join_waiters, so the wake-up can't be missed.
+  if (volatile_read(state) == kStateHasWork) {
+    __atomic_fetch_add(&join_waiters, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&state, __ATOMIC_SEQ_CST) == kStateHasWork) {
+      __sync_fetch_and_add(&join_blocks, 1);
+      futex_wait(&state, kStateHasWork);
+    }
+    __atomic_fetch_sub(&join_waiters, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+void Thread::IdleTask() {
 #if defined(SSN) || defined(SSI)
   TXN::assign_reader_bitmap_entry();
 #endif
@@ -183,18 +447,31 @@ void Thread::IdleTask() {
         }
         logmgr->set_tls_lsn_offset(0);  // clear thread as if did nothing!
       }
-      COMPILER_MEMORY_FENCE;
-      volatile_write(state, kStateNoWork);
+      __atomic_store_n(&state, kStateNoWork, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&join_waiters, __ATOMIC_SEQ_CST)) {
+        futex_wake(&state);
+      }
     }
-    if (sleep_when_idle &&
-        __sync_bool_compare_and_swap(&state, kStateNoWork, kStateSleep)) {
+    if (sleep_when_idle) {
+      // Spin a while in case more work comes right away, then sleep
+      uint64_t start = __rdtsc();
+      uint64_t now = start;
+      while (volatile_read(state) != kStateHasWork && !volatile_read(shutdown) &&
+             now - start < kSpinCycles) {
+        NOP_PAUSE;
+        now = __rdtsc();
+      }
+      idle_spin_cycles += now - start;
+
       // FIXME(tzwang): add a work queue so we can
       // continue if there is more work to do
-      trigger.wait(lock);
-      volatile_write(state, kStateNoWork);
-      // Somebody woke me up, wait for work to do or shutdown
-      while (volatile_read(state) != kStateHasWork && !volatile_read(shutdown)) {
-        /** spin **/
+      if (__sync_bool_compare_and_swap(&state, kStateNoWork, kStateSleep)) {
+        // StartTask moves Sleep to HasWork, Destroy moves it back to NoWork
+        while (volatile_read(state) == kStateSleep && !volatile_read(shutdown)) {
+          ++idle_blocks;
+          futex_wait(&state, kStateSleep);
+        }
+        __sync_bool_compare_and_swap(&state, kStateSleep, kStateNoWork);
       }
     }  // else can't sleep, go check another round
   }
@@ -206,30 +483,49 @@ void Thread::IdleTask() {
 #endif
 }
 
-Thread *PerNodeThreadPool::GetThread(bool physical) {
-retry:
-  uint64_t b = volatile_read(bitmap);
-  uint64_t xor_pos = b ^ (~uint64_t{0});
-  uint64_t pos = __builtin_ctzll(xor_pos);
-
-  Thread *t = nullptr;
-  // Find the thread that matches the preferred type
-  while (true) {
-    if (pos >= max_threads_per_node) {
-      return nullptr;
-    }
-    t = &threads[pos];
-    if ((!((1UL << pos) & b)) && (t->is_physical == physical)) {
-      break;
+void PrintWaitStats(std::ostream &os) {
+  os << "thread_wait_stats (node.core: join spin cycles/blocks, idle spin cycles/blocks):"
+     << std::endl;
+  for (uint32_t i = 0; i < num_thread_pools; ++i) {
+    auto &pool = thread_pools[i];
+    for (uint32_t pos = 0; pos < pool.nthreads; ++pos) {
+      Thread &t = pool.threads[pos];
+      uint64_t join_blocks = volatile_read(t.join_blocks);
+      uint64_t idle_blocks = volatile_read(t.idle_blocks);
+      uint64_t join_spin = volatile_read(t.join_spin_cycles);
+      uint64_t idle_spin = volatile_read(t.idle_spin_cycles);
+      if (join_spin + join_blocks + idle_blocks) {
+        os << "  " << t.node << "." << t.core << ": " << join_spin << "/" << join_blocks
+           << ", " << idle_spin << "/" << idle_blocks << std::endl;
+      }
     }
-    ++pos;
   }
+}
 
-  if (not __sync_bool_compare_and_swap(&bitmap, b, b | (1UL << pos))) {
-    goto retry;
+Thread *PerNodeThreadPool::GetThread(bool physical) {
+  // Scan word by word; a failed CAS only retries the word it was on
+  for (uint32_t w = 0; w < bitmap_words; ++w) {
+  retry:
+    uint64_t b = volatile_read(bitmap[w]);
+    uint64_t free_bits = ~b;
+    // Find the thread that matches the preferred type
+    while (free_bits) {
+      uint32_t bit = __builtin_ctzll(free_bits);
+      uint32_t pos = w * 64 + bit;
+      if (pos >= max_threads_per_node) {
+        return nullptr;
+      }
+      Thread *t = &threads[pos];
+      if (t->is_physical == physical) {
+        if (not __sync_bool_compare_and_swap(&bitmap[w], b, b | (1UL << bit))) {
+          goto retry;
+        }
+        return t;
+      }
+      free_bits &= (free_bits - 1);
+    }
   }
-  ALWAYS_ASSERT(pos < max_threads_per_node);
-  return t;
+  return nullptr;
 }
 }  // namespace thread
 }  // namespace ermia
@@ -1,15 +1,19 @@
 #pragma once
 
+#include <linux/futex.h>
 #include <numa.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <climits>
 #include <condition_variable>
 #include <fstream>
 #include <functional>
 #include <mutex>
+#include <ostream>
 #include <thread>
 
-#include <sys/stat.h>
-
 #include "sm-defs.h"
 #include "xid.h"
 #include "../util.h"
@@ -19,9 +23,11 @@ namespace thread {
 
 struct CPUCore {
   uint32_t node;
+  uint32_t socket;  // physical package
+  int32_t llc;      // last-level cache domain, -1 if unknown
   uint32_t physical_thread;
   std::vector<uint32_t> logical_threads;
-  CPUCore(uint32_t n, uint32_t phys) : node(n), physical_thread(phys) {}
+  CPUCore(uint32_t n, uint32_t phys) : node(n), socket(0), llc(-1), physical_thread(phys) {}
   void AddLogical(uint32_t t) { logical_threads.push_back(t); }
 };
 
@@ -30,6 +36,33 @@ extern std::vector<CPUCore> cpu_cores;
 bool DetectCPUCores();
 void Initialize();
 
+// Background thread classes that config::placement_policy can place
+enum DaemonClass {
+  kDaemonLog,         // log writer and backup log flusher
+  kDaemonCommit,      // command log group-commit flusher
+  kDaemonCheckpoint,
+  kDaemonReplication, // log shipping and backup receive/replay daemons
+  kNumDaemonClasses,
+};
+
+/* Placement policy, a comma-separated list of class=rule:
+     workers=compact|spread  how workers spread over nodes (--numa_spread)
+     <daemon>=core:N         a whole core on node N, taken out of the thread
+                             pool so no worker runs on it or its siblings
+     <daemon>=node:N         any CPU of node N
+     <daemon>=none           no affinity (the default)
+   where <daemon> is log, commit, chkpt or rep. Daemons with core:N on the
+   same node get different cores, picked from the node's last core down,
+   staying in the LLC domain of the first one picked where possible.
+ */
+void ApplyPlacementPolicy();
+
+// Pin the calling thread per the policy for [cls]; no-op if not placed
+void PinDaemon(DaemonClass cls);
+
+// Every core with its socket, node, LLC domain, CPUs and who runs there
+void PrintPlacement(std::ostream &os);
+
 // == total number of threads had so far - never decreases
 extern std::atomic<uint32_t> next_thread_id;
 
@@ -38,16 +71,33 @@ inline uint32_t MyId() {
   thread_local bool thread_initialized CACHE_ALIGNED;
 
   if (!thread_initialized) {
+    // IDs index per-thread arrays that Initialize() sizes
+    LOG_IF(FATAL, !config::max_threads) << "thread::Initialize() hasn't run";
     thread_id = next_thread_id.fetch_add(1);
+    LOG_IF(FATAL, thread_id >= config::max_threads)
+        << "Too many threads, only " << config::max_threads << " thread IDs available";
     thread_initialized = true;
   }
   return thread_id;
 }
 
+inline void futex_wait(uint32_t *addr, uint32_t val) {
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, nullptr, nullptr, 0);
+}
+
+inline void futex_wake(uint32_t *addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
 struct Thread {
-  const uint8_t kStateHasWork = 1U;
-  const uint8_t kStateSleep = 2U;
-  const uint8_t kStateNoWork = 3U;
+  const uint32_t kStateHasWork = 1U;
+  const uint32_t kStateSleep = 2U;
+  const uint32_t kStateNoWork = 3U;
+
+  // How long Join() and an idle thread spin on [state] before blocking on it
+  // in the kernel. Long enough to cover a commit/replay round trip, short
+  // enough not to starve an SMT sibling running a worker.
+  static const uint64_t kSpinCycles = 200000;
 
   typedef std::function<void(char *task_input)> Task;
   pthread_t thd;
@@ -56,14 +106,19 @@ struct Thread {
   uint16_t core;
   uint32_t sys_cpu;  // OS-given CPU number
   bool shutdown;
-  uint8_t state;
+  uint32_t state;  // also the futex word both idle threads and joiners block on
+  uint32_t join_waiters;  // joiners blocked in the kernel
   Task task;
   char *task_input;
   bool sleep_when_idle;
   bool is_physical;
 
-  std::condition_variable trigger;
-  std::mutex trigger_lock;
+  // Wait stats: cycles spent spinning and number of times blocked, for
+  // threads joining this thread and for this thread waiting for work
+  uint64_t join_spin_cycles;
+  uint64_t join_blocks;
+  uint64_t idle_spin_cycles;
+  uint64_t idle_blocks;
 
   Thread();
   Thread(uint16_t n, uint16_t c, uint32_t sys_cpu, bool is_physical);
@@ -79,30 +134,37 @@ struct Thread {
   inline void StartTask(Task t, char *input = nullptr) {
     task = t;
     task_input = input;
-    auto s = __sync_val_compare_and_swap(&state, kStateNoWork, kStateHasWork);
-    if (s == kStateSleep) {
-      while (volatile_read(state) != kStateNoWork) {
-        trigger.notify_all();
+    while (true) {
+      auto s = __sync_val_compare_and_swap(&state, kStateNoWork, kStateHasWork);
+      if (s == kStateNoWork) {
+        return;  // still spinning, will pick it up
+      }
+      ALWAYS_ASSERT(s == kStateSleep);
+      if (__sync_bool_compare_and_swap(&state, kStateSleep, kStateHasWork)) {
+        futex_wake(&state);
+        return;
       }
-      volatile_write(state, kStateHasWork);
-    } else {
-      ALWAYS_ASSERT(s == kStateNoWork);
     }
   }
 
-  inline void Join() { while (volatile_read(state) == kStateHasWork) {} }
+  void Join();
   inline bool TryJoin() { return volatile_read(state) != kStateHasWork; }
   inline void Destroy() {
     volatile_write(shutdown, true);
-    trigger.notify_all();
+    // Kick it out of futex_wait; if it's about to sleep it will see shutdown
+    if (__sync_bool_compare_and_swap(&state, kStateSleep, kStateNoWork)) {
+      futex_wake(&state);
+    }
   }
 };
 
 struct PerNodeThreadPool {
   static uint32_t max_threads_per_node;
+  static uint32_t bitmap_words;  // ceil(max_threads_per_node / 64)
   uint16_t node CACHE_ALIGNED;
+  uint32_t nthreads;  // threads actually on this node
   Thread *threads CACHE_ALIGNED;
-  uint64_t bitmap CACHE_ALIGNED;  // max 64 threads per node, 1 - busy, 0 - free
+  uint64_t *bitmap CACHE_ALIGNED;  // [bitmap_words], 1 - busy, 0 - free
 
   PerNodeThreadPool(uint16_t n);
 
@@ -111,14 +173,19 @@ struct PerNodeThreadPool {
 
   // Release a thread back to the pool
   inline void PutThread(Thread *t) {
-    auto b = ~uint64_t{1UL << (t - threads)};
-    __sync_fetch_and_and(&bitmap, b);
+    uint32_t pos = t - threads;
+    ASSERT(pos < max_threads_per_node);
+    auto b = ~uint64_t{1UL << (pos % 64)};
+    __sync_fetch_and_and(&bitmap[pos / 64], b);
   }
 };
 
 extern PerNodeThreadPool *thread_pools;
 extern uint32_t num_thread_pools;
 
+// Per-thread spin/block counters of pool threads that have waited at all
+void PrintWaitStats(std::ostream &os);
+
 inline Thread *GetThread(uint16_t from, bool physical) {
   if (config::threadpool) {
     return thread_pools[from].GetThread(physical);
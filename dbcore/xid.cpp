@@ -4,6 +4,8 @@
 #include "serial.h"
 #include "../txn.h"
 #include <atomic>
+#include <numa.h>
+#include <sched.h>
 #include <unistd.h>
 
 namespace ermia {
@@ -50,32 +52,47 @@ namespace TXN {
    ago. This is where the epoch manager comes in: it can track
    stragglers and restricts the number of concurrent epochs so that
    the problem cannot arise.
+
+   To keep all of this socket-local, the contexts are split evenly
+   among NUMA nodes and each node runs the above scheme on its own
+   share, with its own bitmaps and epoch manager. A thread allocates
+   from the node it first allocated on (workers are pinned); contexts
+   are freed into the pool that owns them. XIDs from different pools
+   never share a context, so their epochs need not agree.
  */
 xid_context contexts[NCONTEXTS];
 
-xid_bitmap xid_bitmaps[NBITMAPS];
+uint32_t xid_pool::ncontexts = 0;
+uint32_t xid_pool::nwords = 0;
+xid_pool *xid_pools = nullptr;
+uint32_t num_xid_pools = 0;
 
 thread_local thread_data tls CACHE_ALIGNED;
 
 /***************************************
  * * * Callbacks for the epoch_mgr * * *
  ***************************************/
-void global_init(void *) {
+void global_init(void *cookie) {
   /* Set the first row to all ones so we have something to allocate */
+  auto *pool = (xid_pool *)cookie;
   for (int i = 0; i < 2; i++) {
-    for (auto &w : xid_bitmaps[i].data) w = ~uint64_t(0);
+    for (uint32_t w = 0; w < xid_pool::nwords; ++w) {
+      pool->bitmaps[i].data[w] = ~uint64_t(0);
+    }
   }
 }
 
 epoch_mgr::tls_storage *get_tls(void *) {
+  // A thread only ever registers with one pool's epoch manager
   static thread_local epoch_mgr::tls_storage s;
   return &s;
 }
 
-void *thread_registered(void *) {
+void *thread_registered(void *cookie) {
   tls.epoch = 0;
   tls.bitmap = 0;
   tls.base_id = 0;
+  tls.pool = (xid_pool *)cookie;
   tls.initialized = true;
   return &tls;
 }
@@ -101,30 +118,61 @@ void *epoch_ended_thread(void *, void *epoch_cookie, void *) {
 }
 void epoch_reclaimed(void *, void *) {}
 
-epoch_mgr xid_epochs{{nullptr, &global_init, &get_tls, &thread_registered,
-                      &thread_deregistered, &epoch_ended, &epoch_ended_thread,
-                      &epoch_reclaimed}};
+static bool init_pools() {
+  num_xid_pools = numa_max_node() + 1;
+  xid_pool::ncontexts = NCONTEXTS / num_xid_pools / 128 * 128;
+  xid_pool::nwords = xid_pool::ncontexts / 2 / xid_bitmap::BITS_PER_WORD;
+  ALWAYS_ASSERT(xid_pool::nwords);
+
+  xid_pools = (xid_pool *)numa_alloc_interleaved(sizeof(xid_pool) * num_xid_pools);
+  LOG_IF(FATAL, !xid_pools) << "Unable to allocate XID pools";
+  for (uint32_t n = 0; n < num_xid_pools; ++n) {
+    auto &pool = xid_pools[n];
+    pool.node = n;
+    pool.base_id = n * xid_pool::ncontexts;
+    pool.mutex = os_mutex_pod::static_init();
+    for (auto &b : pool.bitmaps) {
+      b.data = (uint64_t *)numa_alloc_onnode(sizeof(uint64_t) * xid_pool::nwords, n);
+      LOG_IF(FATAL, !b.data) << "Unable to allocate XID bitmaps on node " << n;
+      memset(b.data, 0, sizeof(uint64_t) * xid_pool::nwords);
+      b.widx = 0;
+    }
+    pool.epochs = new epoch_mgr({&pool, &global_init, &get_tls, &thread_registered,
+                                 &thread_deregistered, &epoch_ended,
+                                 &epoch_ended_thread, &epoch_reclaimed});
+  }
+  return true;
+}
 
-os_mutex_pod xid_mutex = os_mutex_pod::static_init();
+static void thread_init() {
+  static bool initialized = init_pools();
+  MARK_REFERENCED(initialized);
+  int node = numa_node_of_cpu(sched_getcpu());
+  if (node < 0 || (uint32_t)node >= num_xid_pools) {
+    node = 0;
+  }
+  xid_pools[node].epochs->thread_init();
+}
 
 #if 0
 { // disable autoindent
 #endif
 
 XID xid_alloc() {
-  if (not tls.initialized) xid_epochs.thread_init();
+  if (not tls.initialized) thread_init();
 
+  auto *pool = tls.pool;
   while (not tls.bitmap) {
     /* Grab a whole machine word at a time. Use the epoch_mgr to
        protect us if we happen to straggle. Note that we may
        (through bad luck) acquire an empty word and need to retry.
      */
-    auto e = xid_epochs.thread_enter();
-    DEFER_UNLESS(exited, xid_epochs.thread_exit());
-    auto &b = xid_bitmaps[e % NBITMAPS];
+    auto e = pool->epochs->thread_enter();
+    DEFER_UNLESS(exited, pool->epochs->thread_exit());
+    auto &b = pool->bitmaps[e % NBITMAPS];
     auto i = volatile_read(b.widx);
-    ASSERT(i <= xid_bitmap::NWORDS);
-    while (i < xid_bitmap::NWORDS) {
+    ASSERT(i <= xid_pool::nwords);
+    while (i < xid_pool::nwords) {
       auto j = __sync_val_compare_and_swap(&b.widx, i, i + 1);
       if (j == i) {
         /* NOTE: no need for a goto: the compiler will thread
@@ -135,29 +183,30 @@ XID xid_alloc() {
       i = j;
     }
 
-    if (i == xid_bitmap::NWORDS) {
+    if (i == xid_pool::nwords) {
       // overflow!
-      xid_epochs.thread_exit();
+      pool->epochs->thread_exit();
       exited = true;
 
-      xid_mutex.lock();
-      DEFER(xid_mutex.unlock());
+      pool->mutex.lock();
+      DEFER(pool->mutex.unlock());
 
-      if (e == xid_epochs.get_cur_epoch()) {
+      if (e == pool->epochs->get_cur_epoch()) {
         /* Still at end, try to open a new epoch.
 
            If there are stragglers (highly unlikely) then
            sleep until they leave.
          */
-        xid_bitmaps[(e + 1) % NBITMAPS].widx = 0;
-        while (not xid_epochs.new_epoch()) usleep(1000);
+        pool->bitmaps[(e + 1) % NBITMAPS].widx = 0;
+        while (not pool->epochs->new_epoch()) usleep(1000);
       }
 
       continue;
     }
 
     tls.epoch = e;
-    tls.base_id = (e % 2) * NCONTEXTS / 2 + i * xid_bitmap::BITS_PER_WORD;
+    tls.base_id = pool->base_id + (e % 2) * xid_pool::ncontexts / 2 +
+                  i * xid_bitmap::BITS_PER_WORD;
     std::swap(tls.bitmap, b.data[i]);
   }
 
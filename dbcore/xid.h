@@ -4,6 +4,7 @@
 #include <mutex>
 #include <vector>
 
+#include "../macros.h"
 #include "epoch.h"
 #include "sm-common.h"
 #include "sm-config.h"
@@ -64,14 +65,27 @@ XID xid_alloc();
 static size_t const NBITMAPS = 4;
 struct xid_bitmap {
   static size_t const constexpr BITS_PER_WORD = 8 * sizeof(uint64_t);
-  static size_t const constexpr NWORDS = NCONTEXTS / 2 / BITS_PER_WORD;
-  static_assert(not(NCONTEXTS % (2 * BITS_PER_WORD)),
-                "NCONTEXTS must must divide cleanly by 128");
 
-  uint64_t data[NWORDS];
+  uint64_t *data;  // [xid_pool::nwords], allocated on the pool's node
   size_t widx;
 };
-extern xid_bitmap xid_bitmaps[NBITMAPS];
+
+/* Each NUMA node owns a contiguous share of the contexts and hands them out
+   with its own bitmaps and epoch manager (see xid.cpp), so allocation,
+   rollover and (usually) free never leave the socket.
+ */
+struct xid_pool {
+  static uint32_t ncontexts;  // contexts per pool, a multiple of 128
+  static uint32_t nwords;     // words per bitmap: ncontexts / 2 / 64
+
+  uint32_t node;
+  uint32_t base_id;  // first context owned by this pool
+  epoch_mgr *epochs;
+  os_mutex_pod mutex;  // serializes bitmap rollover
+  xid_bitmap bitmaps[NBITMAPS];
+} CACHE_ALIGNED;
+extern xid_pool *xid_pools;
+extern uint32_t num_xid_pools;
 
 /* Release an XID and its associated context. The XID will no longer
    be associated with any context after this call returns.
@@ -86,8 +100,9 @@ inline void xid_free(XID x) {
   // read very stale XID and try to find its context)
   ctx->owner._val = 0;
 
-  auto &b = xid_bitmaps[x.epoch() % NBITMAPS];
-  auto &w = b.data[(id / xid_bitmap::BITS_PER_WORD) % xid_bitmap::NWORDS];
+  auto &pool = xid_pools[id / xid_pool::ncontexts];
+  auto &b = pool.bitmaps[x.epoch() % NBITMAPS];
+  auto &w = b.data[((id - pool.base_id) / xid_bitmap::BITS_PER_WORD) % xid_pool::nwords];
   auto bit = id % xid_bitmap::BITS_PER_WORD;
   __sync_fetch_and_or(&w, uint64_t(1) << bit);
 }
@@ -115,6 +130,7 @@ struct thread_data {
   epoch_mgr::epoch_num epoch;
   uint64_t bitmap;
   uint32_t base_id;
+  xid_pool *pool;  // the pool of the node this thread first allocated on
   bool initialized;
 };
 
@@ -8,6 +8,8 @@
 
 namespace ermia {
 
+thread_local BatchProbeCache *tls_batch_probe_cache = nullptr;
+
 // Engine initialization, including creating the OID, log, and checkpoint
 // managers and recovery if needed.
 Engine::Engine() {
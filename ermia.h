@@ -69,6 +69,82 @@ public:
   rc_t Remove(transaction &t, OID oid);
 };
 
+// Per-batch cache of index probes for batched same-type execution
+// (BATCH_SAME_TRX). Transactions of one type in a batch tend to look up the
+// same hot keys (e.g., warehouse, district and item rows in TPC-C), so the
+// first to find a key records its OID and the others skip the tree descent.
+// Only keys with a committed version are cached, as those keep mapping to
+// the same OID (deletes install tombstone versions). Each transaction still
+// walks the version chain on its own, so visibility and read/write tracking
+// stay per transaction. Direct-mapped, cleared in O(1) per batch.
+class BatchProbeCache {
+public:
+  static const uint32_t kSlots = 1024;  // must be a power of two
+  static const uint32_t kMaxKeySize = 48;
+
+  BatchProbeCache() : generation_(1), hits_(0), misses_(0) {
+    memset(entries_, 0, sizeof(entries_));
+  }
+
+  inline void Clear() { ++generation_; }
+
+  inline bool Get(OrderedIndex *index, const varstr &key, OID &out_oid) {
+    if (key.size() > kMaxKeySize) {
+      return false;
+    }
+    Entry &e = entries_[Slot(index, key)];
+    if (e.generation != generation_ || e.index != index || e.key_size != key.size() ||
+        memcmp(e.key, key.data(), key.size())) {
+      ++misses_;
+      return false;
+    }
+    ++hits_;
+    out_oid = e.oid;
+    return true;
+  }
+
+  inline void Put(OrderedIndex *index, const varstr &key, OID oid) {
+    if (key.size() > kMaxKeySize) {
+      return;
+    }
+    Entry &e = entries_[Slot(index, key)];
+    e.generation = generation_;
+    e.index = index;
+    e.oid = oid;
+    e.key_size = key.size();
+    memcpy(e.key, key.data(), key.size());
+  }
+
+  inline uint64_t hits() const { return hits_; }
+  inline uint64_t misses() const { return misses_; }
+
+private:
+  struct Entry {
+    uint64_t generation;
+    OrderedIndex *index;
+    OID oid;
+    uint32_t key_size;
+    char key[kMaxKeySize];
+  };
+
+  inline uint32_t Slot(OrderedIndex *index, const varstr &key) const {
+    // FNV-1a over the key, seeded with the index
+    uint64_t h = 14695981039346656037ULL ^ reinterpret_cast<uintptr_t>(index);
+    for (uint32_t i = 0; i < key.size(); ++i) {
+      h = (h ^ key.data()[i]) * 1099511628211ULL;
+    }
+    return h & (kSlots - 1);
+  }
+
+  uint64_t generation_;
+  uint64_t hits_;
+  uint64_t misses_;
+  Entry entries_[kSlots];
+};
+
+// Set by the batch scheduler while it runs a batch, nullptr otherwise
+extern thread_local BatchProbeCache *tls_batch_probe_cache;
+
 // User-facing concurrent Masstree
 class ConcurrentMasstreeIndex : public OrderedIndex {
   friend struct sm_log_recover_impl;
@@ -153,6 +229,23 @@ public:
   static void simple_coro_MultiOps(std::vector<rc_t> &rcs,
 		                   std::vector<std::experimental::coroutine_handle<ermia::coro::generator<rc_t>::promise_type>> &handles);
 
+  // One range of a multi-scan; end_key == nullptr means no upper bound
+  struct ScanRange {
+    ScanRange(const varstr *start_key, const varstr *end_key, ScanCallback *callback,
+              uint32_t limit = ~uint32_t{0})
+        : start_key(start_key), end_key(end_key), callback(callback), limit(limit) {}
+    const varstr *start_key;
+    const varstr *end_key;
+    ScanCallback *callback;
+    uint32_t limit;  // maximum number of records to hand to callback
+  };
+
+  // A multi-scan interface using coroutines: the descents and leaf walks of
+  // independent ranges are interleaved so that their cache misses overlap.
+  // rcs[i] gets the result of ranges[i].
+  void simple_coro_MultiScan(transaction *t, std::vector<ScanRange> &ranges, std::vector<rc_t> &rcs,
+                             std::vector<std::experimental::coroutine_handle<ermia::coro::generator<rc_t>::promise_type>> &handles);
+
   ermia::coro::generator<rc_t> coro_GetRecord(transaction *t, const varstr &key, varstr &value, OID *out_oid = nullptr);
   ermia::coro::generator<rc_t> coro_GetRecordSV(transaction *t, const varstr &key, varstr &value, OID *out_oid = nullptr);
   ermia::coro::generator<rc_t> coro_UpdateRecord(transaction *t, const varstr &key, varstr &value);
@@ -463,6 +463,7 @@ public:
     ermia::dbtuple *tuple_;
     mbtree<P> *btr_;
     int scancount_;
+    const void *last_leaf_;
 
   public:
    ScanIterator(TXN::xid_context *xc, mbtree<P> *btr, const key_type &lower,
@@ -470,9 +471,21 @@ public:
        : sinfo_(btr->get_table(), lower),
          scanner_(btr, upper),
          xc_(xc),
-         btr_(btr) {}
+         btr_(btr),
+         last_leaf_(nullptr) {}
    int count() const { return scancount_; }
 
+   // True once each time the scan has moved on to another leaf, so that
+   // long scans can yield to other transactions at leaf boundaries
+   bool crossed_leaf() {
+     const void *leaf = sinfo_.stack[sinfo_.stackpos].n_;
+     if (leaf == last_leaf_) {
+       return false;
+     }
+     last_leaf_ = leaf;
+     return true;
+   }
+
    OID value() const { return sinfo_.entry.value(); }
    Masstree::Str key() { return sinfo_.ka.full_string(); }
 
@@ -525,6 +538,7 @@ public:
     ermia::dbtuple *tuple_;
     mbtree<P> *btr_;
     int scancount_;
+    const void *last_leaf_;
 
   public:
     coro_ScanIterator(TXN::xid_context *xc, mbtree<P> *btr, const key_type &lower,
@@ -532,9 +546,20 @@ public:
         : sinfo_(btr->get_table(), lower),
           scanner_(btr, upper),
           xc_(xc),
-          btr_(btr) {}
+          btr_(btr),
+          last_leaf_(nullptr) {}
     int count() const { return scancount_; }
 
+    // See ScanIterator::crossed_leaf()
+    bool crossed_leaf() {
+      const void *leaf = sinfo_.stack[sinfo_.stackpos].n_;
+      if (leaf == last_leaf_) {
+        return false;
+      }
+      last_leaf_ = leaf;
+      return true;
+    }
+
     OID value() const { return sinfo_.entry.value(); }
     Masstree::Str key() { return sinfo_.ka.full_string(); }
 
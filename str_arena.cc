@@ -0,0 +1,127 @@
+#include <numa.h>
+#include <sys/mman.h>
+
+#include "str_arena.h"
+
+namespace ermia {
+
+// Summed over all arenas; only touched when a chunk is mapped or unmapped,
+// or when an arena sets a new high-water mark
+static std::atomic<uint64_t> arena_chunk_bytes(0);
+static std::atomic<uint64_t> arena_max_high_water(0);
+
+str_arena::chunk *str_arena::alloc_chunk(size_t size) {
+  // Over-map by a huge page so the chunk can start on a huge page boundary,
+  // which THP needs. Nothing is touched here; pages are faulted in (on the
+  // local node) as the arena bumps through them.
+  size_t bytes = size + kHeaderSize;
+  ASSERT(bytes % kHugePageSize == 0);
+  char *p = (char *)mmap(nullptr, bytes + kHugePageSize, PROT_READ | PROT_WRITE,
+                         MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+  LOG_IF(FATAL, p == MAP_FAILED) << "Unable to allocate " << bytes
+                                 << " bytes of arena: " << strerror(errno);
+  char *start = (char *)align_up((uintptr_t)p, kHugePageSize);
+  if (start != p) {
+    munmap(p, start - p);
+  }
+  munmap(start + bytes, p + kHugePageSize - start);
+  madvise(start, bytes, MADV_HUGEPAGE);
+  numa_setlocal_memory(start, bytes);
+
+  chunk *c = (chunk *)start;
+  c->next = nullptr;
+  c->size = size;
+  arena_chunk_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  return c;
+}
+
+void str_arena::free_chunk(chunk *c) {
+  size_t bytes = c->size + kHeaderSize;
+  arena_chunk_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  munmap(c, bytes);
+}
+
+str_arena::~str_arena() {
+  while (head) {
+    chunk *c = head;
+    head = head->next;
+    free_chunk(c);
+  }
+}
+
+void str_arena::grow(uint64_t len) {
+  chunk *c = nullptr;
+  if (cur) {
+    used_before += n;
+    c = cur->next;
+  } else {
+    c = head;
+  }
+  if (!c || c->size < len) {
+    size_t size = chunk_size();
+    if (len > size) {
+      size = align_up(len + kHeaderSize, kHugePageSize) - kHeaderSize;
+    }
+    chunk *nc = alloc_chunk(size);
+    nc->next = c;
+    if (cur) {
+      cur->next = nc;
+    } else {
+      head = nc;
+    }
+    c = nc;
+  }
+  cur = c;
+  str = data(c);
+  capacity = c->size;
+  n = 0;
+}
+
+void str_arena::rewind() {
+  size_t used = used_before + n;
+  if (used > high_water) {
+    high_water = used;
+    auto max = arena_max_high_water.load(std::memory_order_relaxed);
+    while (used > max && !arena_max_high_water.compare_exchange_weak(max, used)) {
+    }
+  }
+
+  // Keep standard chunks for the next transaction
+  size_t standard = chunk_size();
+  chunk **prev = &head;
+  while (*prev) {
+    chunk *c = *prev;
+    if (c->size > standard) {
+      *prev = c->next;
+      free_chunk(c);
+    } else {
+      prev = &c->next;
+    }
+  }
+
+  cur = head;
+  str = head ? data(head) : nullptr;
+  capacity = head ? head->size : 0;
+  used_before = 0;
+}
+
+bool str_arena::manages(const varstr *px) const {
+  for (chunk *c = head; c; c = c->next) {
+    const char *begin = data(c);
+    const char *end = begin + (c == cur ? n : c->size);
+    if ((const char *)px >= begin and px->data() + px->size() <= (const uint8_t *)end) {
+      return true;
+    }
+    if (c == cur) {
+      break;
+    }
+  }
+  return false;
+}
+
+void str_arena::print_stats(std::ostream &os) {
+  os << "str_arena: max high-water " << arena_max_high_water.load() / 1024
+     << "KB per transaction, " << arena_chunk_bytes.load() / config::MB
+     << "MB mapped in chunks" << std::endl;
+}
+}  // namespace ermia
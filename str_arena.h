@@ -5,22 +5,28 @@
 #include "varstr.h"
 #include <atomic>
 #include <memory>
+#include <ostream>
 
 namespace ermia {
+// Transaction-private bump allocator for keys and values. Memory comes in
+// NUMA-local chunks of config::arena_size_mb, mapped on first use and
+// backed by (transparent) huge pages where possible. The arena grows by a
+// chunk when the current one is full (or by one big chunk for a single
+// oversized request), and reset() rewinds to the first chunk, keeping the
+// standard-sized ones for the next transaction.
 class str_arena {
 public:
   static const size_t MinStrReserveLength = 2 * CACHELINE_SIZE;
-  str_arena(uint32_t size_mb) : n(0) {
+  static const size_t kHugePageSize = 2 * config::MB;
+
+  str_arena(uint32_t size_mb)
+      : str(nullptr), n(0), capacity(0), head(nullptr), cur(nullptr),
+        used_before(0), high_water(0) {
     // Make sure arena is only initialized after config is initialized so we have
     // a valid size
     ALWAYS_ASSERT(size_mb == config::arena_size_mb);
-
-    // adler32 (log checksum) needs it aligned
-    ALWAYS_ASSERT(
-        not posix_memalign((void **)&str, DEFAULT_ALIGNMENT, size_mb * config::MB));
-    memset(str, '\0', config::arena_size_mb * config::MB);
-    reset();
   }
+  ~str_arena();
 
   // non-copyable/non-movable for the time being
   str_arena(str_arena &&) = delete;
@@ -28,40 +34,69 @@ public:
   str_arena &operator=(const str_arena &) = delete;
 
   inline void reset() {
-    ASSERT(n < config::arena_size_mb * config::MB);
+    if (unlikely(cur != head || n > high_water)) {
+      rewind();
+    }
     n = 0;
   }
 
-  varstr *next(uint64_t size) {
+  inline varstr *next(uint64_t size) {
+    uint64_t len = align_up(size + sizeof(varstr));
+    if (unlikely(n + len > capacity)) {
+      grow(len);
+    }
     uint64_t off = n;
-    n += align_up(size + sizeof(varstr));
-    ASSERT(n < config::arena_size_mb * config::MB);
+    n += len;
     varstr *ret = new (str + off) varstr(str + off + sizeof(varstr), size);
     return ret;
   }
 
-  // Assume the caller is the benchmark using str(Size(v))
+  // Assume the caller is the benchmark using str(Size(v)), undoing its
+  // latest next(). If that one started a new chunk the rest of the
+  // previous chunk stays unused until reset().
   inline void return_space(uint64_t size) {
-    n -= (align_up(size + sizeof(varstr)));
-  }
-
-  varstr *atomic_next(uint64_t size) {
-    uint64_t off = __atomic_fetch_add(&n, align_up(size + sizeof(varstr)), __ATOMIC_ACQ_REL);
-    ASSERT(n < config::arena_size_mb * config::MB);
-    varstr *ret = new (str + off) varstr(str + off + sizeof(varstr), size);
-    return ret;
+    uint64_t len = align_up(size + sizeof(varstr));
+    n = n >= len ? n - len : 0;
   }
 
   inline varstr *operator()(uint64_t size) { return next(size); }
 
-  bool manages(const varstr *px) const {
-    return (const char *)px >= str and
-           (uint64_t) px->data() + px->size() <= (uint64_t)str + n;
-  }
+  bool manages(const varstr *px) const;
+
+  // Most bytes a single transaction has used in this arena
+  inline size_t high_water_mark() const { return high_water; }
+
+  // Max high-water mark and total chunk memory over all arenas
+  static void print_stats(std::ostream &os);
 
 private:
-  char *str;
-  size_t n;
+  struct chunk {
+    chunk *next;
+    size_t size;  // usable bytes, starting kHeaderSize into the chunk
+  };
+  static const size_t kHeaderSize = CACHELINE_SIZE;
+
+  static inline char *data(chunk *c) { return (char *)c + kHeaderSize; }
+  static chunk *alloc_chunk(size_t size);
+  static void free_chunk(chunk *c);
+
+  inline size_t chunk_size() const {
+    return align_up(config::arena_size_mb * config::MB, kHugePageSize) - kHeaderSize;
+  }
+
+  // Move to (or add) a chunk after the current one with room for [len]
+  void grow(uint64_t len);
+  // Go back to the first chunk, recording the high-water mark and giving
+  // back oversized chunks
+  void rewind();
+
+  char *str;          // data of the current chunk
+  size_t n;           // bytes used in the current chunk
+  size_t capacity;    // usable bytes in the current chunk
+  chunk *head;
+  chunk *cur;
+  size_t used_before;  // bytes used in chunks before the current one
+  size_t high_water;
 };
 
 class scoped_str_arena {
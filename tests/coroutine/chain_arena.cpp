@@ -0,0 +1,101 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <sm-coroutine.h>
+
+using ermia::coro::chain_arena;
+using ermia::coro::coroutine_allocator;
+using ermia::coro::task;
+using ermia::coro::tcalloc;
+
+// Doesn't suspend, just hands the awaiting coroutine's frame to [frames]
+struct record_frame {
+    std::vector<void *> *frames;
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::experimental::coroutine_handle<> h) noexcept {
+        frames->push_back(h.address());
+        return false;
+    }
+    void await_resume() const noexcept {}
+};
+
+// Every level records its frame (outermost first), the leaf suspends once
+task<uint32_t> nested_call(uint32_t depth, std::vector<void *> *frames) {
+    co_await record_frame{frames};
+    if (depth == 0) {
+        co_await std::experimental::suspend_always{};
+        co_return 1;
+    }
+    uint32_t n = co_await nested_call(depth - 1, frames);
+    co_return n + 1;
+}
+
+static uint64_t tcalloc_live_frames() {
+    uint64_t live = coroutine_allocator.get_large_stats().live;
+    for (uint32_t i = 0; i < tcalloc::kNumSizeClasses; ++i) {
+        live += coroutine_allocator.get_stats(i).live;
+    }
+    return live;
+}
+
+TEST(ChainArenaTest, AllocAndReset) {
+    chain_arena arena(1024);
+    void *p = arena.alloc(100);
+    ASSERT_NE(p, nullptr);
+    ASSERT_TRUE(chain_arena::is_chain_frame(p));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0UL);
+    ASSERT_GE(arena.used(), 100UL);
+
+    // Doesn't fit anymore
+    ASSERT_EQ(arena.alloc(1024), nullptr);
+
+    const size_t used = arena.used();
+    arena.reset();
+    ASSERT_EQ(arena.used(), 0UL);
+    ASSERT_EQ(arena.high_water(), used);
+    ASSERT_EQ(arena.alloc(100), p);
+}
+
+TEST(ChainArenaTest, OverflowToTcalloc) {
+    const uint32_t kDepth = 256;
+    chain_arena arena(4096);
+    const uint64_t live_before = tcalloc_live_frames();
+
+    std::vector<void *> frames;
+    task<uint32_t> t = nested_call(kDepth, &frames);
+    t.start(&arena);
+    ASSERT_FALSE(t.done());
+    ASSERT_EQ(frames.size(), kDepth + 1);
+
+    // The root comes from tcalloc, nested frames from the arena until it's
+    // full, then from tcalloc again
+    ASSERT_FALSE(chain_arena::is_chain_frame(frames[0]));
+    ASSERT_TRUE(chain_arena::is_chain_frame(frames[1]));
+    uint32_t first_overflow = 1;
+    while (first_overflow <= kDepth && chain_arena::is_chain_frame(frames[first_overflow])) {
+        ++first_overflow;
+    }
+    ASSERT_LE(first_overflow, kDepth) << "chain never outgrew the arena";
+    for (uint32_t i = first_overflow; i <= kDepth; ++i) {
+        ASSERT_FALSE(chain_arena::is_chain_frame(frames[i])) << "level " << i;
+    }
+    ASSERT_GT(arena.used(), 4096UL / 2);
+    ASSERT_EQ(tcalloc_live_frames() - live_before, kDepth + 2 - first_overflow);
+
+    while (!t.done()) {
+        t.resume();
+    }
+    ASSERT_EQ(t.get_return_value(), kDepth + 1);
+
+    // Fallback frames went back to tcalloc as they finished, the root goes
+    // with the task; the arena keeps its frames until the owner resets it
+    ASSERT_EQ(tcalloc_live_frames() - live_before, 1UL);
+    t = task<uint32_t>(nullptr);
+    ASSERT_EQ(tcalloc_live_frames(), live_before);
+    const size_t used = arena.used();
+    ASSERT_GT(used, 0UL);
+    arena.reset();
+    ASSERT_EQ(arena.used(), 0UL);
+    ASSERT_EQ(arena.high_water(), used);
+}
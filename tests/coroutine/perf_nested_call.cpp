@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include <sm-coroutine.h>
+
+using ermia::coro::task;
+using ermia::coro::chain_arena;
+
+// A chain of [depth] nested tasks whose leaf suspends once, i.e., one
+// index probe that prefetches and yields at the bottom of the call tree.
+task<uint64_t> nested_call(uint32_t depth) {
+    if (depth == 0) {
+        co_await std::experimental::suspend_always{};
+        co_return 1;
+    }
+    uint64_t n = co_await nested_call(depth - 1);
+    co_return n + 1;
+}
+
+static void run_chain(benchmark::State &state, chain_arena *arena) {
+    const uint32_t depth = state.range(0);
+    uint64_t calls = 0;
+    for (auto _ : state) {
+        task<uint64_t> t = nested_call(depth);
+        t.start(arena);
+        while (!t.done()) {
+            t.resume();
+        }
+        calls += t.get_return_value();
+        t = task<uint64_t>(nullptr);
+        if (arena) {
+            arena->reset();
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+
+static void BM_NestedCallTcalloc(benchmark::State &state) {
+    run_chain(state, nullptr);
+}
+
+static void BM_NestedCallChainArena(benchmark::State &state) {
+    chain_arena arena;
+    run_chain(state, &arena);
+}
+
+BENCHMARK(BM_NestedCallTcalloc)->RangeMultiplier(2)->Range(1, 32);
+BENCHMARK(BM_NestedCallChainArena)->RangeMultiplier(2)->Range(1, 32);
@@ -0,0 +1,66 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <sm-coroutine.h>
+
+using ermia::coro::tcalloc;
+
+TEST(TcallocTest, ReuseFreedFrame) {
+    tcalloc a;
+    void *p = a.alloc(100);
+    a.free(p, 100);
+    void *q = a.alloc(200);  // same size class
+    ASSERT_EQ(p, q);
+    ASSERT_EQ(a.get_stats(0).live, 1UL);
+    ASSERT_EQ(a.get_stats(0).peak, 1UL);
+    // Reused rather than carved again
+    ASSERT_EQ(a.get_stats(0).carved_bytes, a.get_stats(0).live_bytes);
+    a.free(q, 200);
+    ASSERT_EQ(a.get_stats(0).live, 0UL);
+    ASSERT_EQ(a.get_stats(0).live_bytes, 0UL);
+}
+
+TEST(TcallocTest, GrowBeyondOneChunk) {
+    tcalloc a;
+    const size_t kFrameSize = 64 * 1024;
+    const size_t kFrames = 3 * tcalloc::kChunkSize / kFrameSize;
+    std::vector<void *> frames;
+    for (size_t i = 0; i < kFrames; ++i) {
+        void *p = a.alloc(kFrameSize);
+        memset(p, 0xab, kFrameSize);
+        frames.push_back(p);
+    }
+    ASSERT_GT(a.get_nchunks(), 3UL);
+
+    const uint32_t entry_index = tcalloc::lg_up(kFrameSize) - tcalloc::kBeginSizeExp;
+    ASSERT_EQ(a.get_stats(entry_index).live, kFrames);
+    ASSERT_EQ(a.get_stats(entry_index).peak, kFrames);
+    for (void *p : frames) {
+        a.free(p, kFrameSize);
+    }
+    ASSERT_EQ(a.get_stats(entry_index).live, 0UL);
+    ASSERT_EQ(a.get_stats(entry_index).live_bytes, 0UL);
+    ASSERT_EQ(a.get_stats(entry_index).peak, kFrames);
+}
+
+TEST(TcallocTest, LargeFrame) {
+    tcalloc a;
+    const size_t kFrameSize = 4 * tcalloc::kChunkSize;
+    void *p = a.alloc(kFrameSize);
+    memset(p, 0xcd, kFrameSize);
+    ASSERT_EQ(a.get_large_stats().live, 1UL);
+    a.free(p, kFrameSize);
+    ASSERT_EQ(a.get_large_stats().live, 0UL);
+    ASSERT_EQ(a.get_large_stats().live_bytes, 0UL);
+    ASSERT_GE(a.get_large_stats().carved_bytes, kFrameSize);
+}
+
+#ifndef NDEBUG
+TEST(TcallocDeathTest, CrossThreadFree) {
+    tcalloc a, b;
+    void *p = a.alloc(100);
+    ASSERT_DEATH(b.free(p, 100), "doesn't own");
+    a.free(p, 100);
+}
+#endif
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <epoch.h>
+
+using ermia::epoch_mgr;
+
+// Enter/exit cost of epoch_mgr as the number of registered threads grows,
+// with and without another thread advancing the epoch meanwhile.
+
+static void global_init(void *) {}
+static epoch_mgr::tls_storage *get_tls(void *) {
+    static thread_local epoch_mgr::tls_storage s;
+    return &s;
+}
+static void *thread_registered(void *) { return nullptr; }
+static void thread_deregistered(void *, void *) {}
+static void *epoch_ended(void *, epoch_mgr::epoch_num e) { return (void *)(e + 1); }
+static void *epoch_ended_thread(void *, void *epoch_cookie, void *) { return epoch_cookie; }
+static void epoch_reclaimed(void *, void *) {}
+
+static epoch_mgr em{{nullptr, &global_init, &get_tls, &thread_registered,
+                     &thread_deregistered, &epoch_ended, &epoch_ended_thread,
+                     &epoch_reclaimed}};
+
+static void ensure_registered() {
+    // Benchmark threads go away after each run; epoch_mgr deregisters them
+    if (!em.thread_initialized()) {
+        em.thread_init();
+    }
+}
+
+static void BM_EnterExit(benchmark::State &state) {
+    ensure_registered();
+    for (auto _ : state) {
+        auto e = em.thread_enter();
+        benchmark::DoNotOptimize(e);
+        em.thread_exit();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_EnterExitWithAdvance(benchmark::State &state) {
+    ensure_registered();
+    uint64_t n = 0;
+    for (auto _ : state) {
+        auto e = em.thread_enter();
+        benchmark::DoNotOptimize(e);
+        em.thread_exit();
+        // One thread keeps moving the epoch, like the GC does
+        if (state.thread_index == 0 && ++n % 1024 == 0 && em.new_epoch_possible()) {
+            em.new_epoch();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EnterExit)->Threads(1)->Threads(8)->Threads(32)->Threads(96)->Threads(128)->UseRealTime();
+BENCHMARK(BM_EnterExitWithAdvance)->Threads(1)->Threads(8)->Threads(32)->Threads(96)->Threads(128)->UseRealTime();
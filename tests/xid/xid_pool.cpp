@@ -0,0 +1,88 @@
+#include <numa.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <xid.h>
+
+using namespace ermia;
+
+// Every CPU allocates and frees as fast as it can, holding a few XIDs at a
+// time so that contexts are recycled out of order and the pools roll over
+// their bitmaps. No two live XIDs may share a context, and each thread only
+// gets contexts from its own node's pool.
+
+static const uint32_t kMaxThreads = 256;
+static const uint32_t kHeld = 8;
+
+static std::atomic<uint8_t> in_use[TXN::NCONTEXTS];
+
+static void pin_to_cpu(uint32_t cpu) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    ASSERT_EQ(pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset), 0);
+}
+
+static void release(XID xid, TXN::txn_state state) {
+    auto *ctx = TXN::xid_get_context(xid);
+    ASSERT_NE(ctx, nullptr);
+    ctx->state = state;
+    in_use[xid.local()] = 0;
+    TXN::xid_free(xid);
+}
+
+static void stress(uint32_t cpu, uint64_t nallocs) {
+    pin_to_cpu(cpu);
+    int node = numa_node_of_cpu(cpu);
+    if (node < 0 || (uint32_t)node >= TXN::num_xid_pools) {
+        node = 0;
+    }
+
+    XID held[kHeld];
+    uint32_t nheld = 0;
+    for (uint64_t n = 1; n <= nallocs; ++n) {
+        XID xid = TXN::xid_alloc();
+        auto id = xid.local();
+        uint8_t expected = 0;
+        ASSERT_TRUE(in_use[id].compare_exchange_strong(expected, 1)) << "context " << id << " handed out twice";
+        ASSERT_EQ(id / TXN::xid_pool::ncontexts, (uint32_t)node);
+        ASSERT_EQ(TXN::xid_get_context(xid), &TXN::contexts[id]);
+
+        if (nheld == kHeld) {
+            // Free a random one of the held XIDs
+            uint32_t victim = n % kHeld;
+            release(held[victim], TXN::TXN_CMMTD);
+            held[victim] = xid;
+        } else {
+            held[nheld++] = xid;
+        }
+    }
+
+    for (uint32_t i = 0; i < nheld; ++i) {
+        release(held[i], TXN::TXN_ABRTD);
+    }
+}
+
+TEST(XidPool, PerNodeStress) {
+    uint32_t ncpus = std::min<uint32_t>(std::thread::hardware_concurrency(), kMaxThreads);
+    // Enough for every pool to go through all of its bitmaps at least once
+    uint64_t nallocs = 2 * TXN::NCONTEXTS / ncpus;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < ncpus; ++i) {
+        threads.emplace_back(stress, i, nallocs);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (uint32_t i = 0; i < TXN::NCONTEXTS; ++i) {
+        ASSERT_EQ(in_use[i], 0) << "context " << i << " leaked";
+    }
+}
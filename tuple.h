@@ -22,7 +22,7 @@ namespace ermia {
 struct dbtuple {
  public:
 #if defined(SSN) || defined(SSI)
-  TXN::readers_list::bitmap_t readers_bitmap;  // bitmap of in-flight readers
+  TXN::reader_slots readers;  // in-flight readers
   fat_ptr sstamp;  // successor (overwriter) stamp (\pi in ssn), set to writer
                    // XID during
   // normal write to indicate its existence; become writer cstamp at commit
@@ -131,7 +131,7 @@ void transaction::Abort() {
     auto &r = read_set[i];
     ASSERT(r->GetObject()->GetClsn().asi_type() == fat_ptr::ASI_LOG);
     // remove myself from reader list
-    serial_deregister_reader_tx(coro_batch_idx, &r->readers_bitmap);
+    serial_deregister_reader_tx(coro_batch_idx, &r->readers);
   }
 #endif
 
@@ -350,16 +350,16 @@ rc_t transaction::parallel_ssn_commit() {
 
     ASSERT(XID::from_ptr(volatile_read(overwritten_tuple->sstamp)) == xid);
 
-    // Do this before examining the preader field and reading the readers bitmap
+    // Do this before examining the preader field and reading the reader slots
     overwritten_tuple->lockout_read_mostly_tx();
 
     // Now readers who think this is an old version won't be able to read it
-    // Then read the readers bitmap - it's guaranteed to cover all possible
+    // Then read the reader slots - it's guaranteed to cover all possible
     // readers (those who think it's an old version) as we
     // lockout_read_mostly_tx()
     // first. Readers who think this is a young version can still come at any
     // time - they will be handled by the orignal SSN machinery.
-    TXN::readers_bitmap_iterator readers_iter(&overwritten_tuple->readers_bitmap);
+    TXN::readers_iterator readers_iter(&overwritten_tuple->readers);
     while (true) {
       int32_t xid_idx = readers_iter.next(coro_batch_idx, true);
       if (xid_idx == -1) break;
@@ -639,7 +639,7 @@ rc_t transaction::parallel_ssn_commit() {
     // the updater will be able to see the correct xstamp after noticed
     // a context change; otherwise it might miss it and read a too-old
     // xstamp that was set by some earlier reader.
-    serial_deregister_reader_tx(coro_batch_idx, &r->readers_bitmap);
+    serial_deregister_reader_tx(coro_batch_idx, &r->readers);
   }
   return rc_t{RC_TRUE};
 }
@@ -664,7 +664,7 @@ rc_t transaction::parallel_ssi_commit() {
   // Reader's protocol:
   // 1. If sstamp is not set: no updater yet, but if later an updater comes,
   //    it will enter precommit after me (if it can survive). So by the time
-  //    the updater started to look at the readers bitmap, if I'm still in
+  //    the updater started to look at the reader slots, if I'm still in
   //    precommit, I need to make sure it sees me on the bitmap (trivial, as
   //    I won't change any bitmaps after enter precommit); or if I committed,
   //    I need to make sure it sees my updated xstamp. This essentially means
@@ -698,7 +698,7 @@ rc_t transaction::parallel_ssi_commit() {
   //       out from the bitmap.
   //
   //  The writer then doesn't have much burden, it just needs to take a look
-  //  at the readers bitmap and abort if any reader is still active or any
+  //  at the reader slots and abort if any reader is still active or any
   //  xstamp > ct3; overwritten versions' xstamp are guaranteed to be valid
   //  because the reader won't remove itself from the bitmap unless it updated
   //  v.xstamp.
@@ -788,7 +788,7 @@ rc_t transaction::parallel_ssi_commit() {
     // all s2 values.
     COMPILER_MEMORY_FENCE;
     if (volatile_read(r->s2)) return {RC_ABORT_SERIAL};
-    // Release read lock (readers bitmap) after setting xstamp in post-commit
+    // Release read lock (reader slots) after setting xstamp in post-commit
   }
 
   if (ct3) {
@@ -805,7 +805,7 @@ rc_t transaction::parallel_ssi_commit() {
       // in that case. So the reader should make sure when it goes away
       // from the bitmap, xstamp is ready to be read by the updater.
 
-      TXN::readers_bitmap_iterator readers_iter(&overwritten_tuple->readers_bitmap);
+      TXN::readers_iterator readers_iter(&overwritten_tuple->readers);
       while (true) {
         int32_t xid_idx = readers_iter.next(coro_batch_idx, true);
         if (xid_idx == -1) break;
@@ -959,7 +959,7 @@ rc_t transaction::parallel_ssi_commit() {
     // so effectively means I'm holding my position on in the bitmap
     // and preventing it from being reused by another reader before
     // the overwriter leaves. So the overwriter will be able to see
-    // a stable readers bitmap and tell if there's an active reader
+    // a stable reader slots and tell if there's an active reader
     // and if so then whether it has to abort because it found itself
     // being an unlucky T2.
     auto sstamp = volatile_read(r->sstamp);
@@ -980,7 +980,7 @@ rc_t transaction::parallel_ssi_commit() {
     // now it's safe to release my seat!
     // Need to do this after setting xstamp, so that the updater can
     // see the xstamp if it didn't find the bit in the bitmap is set.
-    serial_deregister_reader_tx(coro_batch_idx, &r->readers_bitmap);
+    serial_deregister_reader_tx(coro_batch_idx, &r->readers);
   }
   return rc_t{RC_TRUE};
 }
@@ -1184,14 +1184,14 @@ rc_t transaction::Update(TableDescriptor *td, OID oid, const varstr *k, varstr *
       if (xc->ct3 <= xc->last_safesnap) return {RC_ABORT_SERIAL};
 
       if (volatile_read(prev->xstamp) >= xc->ct3 or
-          not prev->readers_bitmap.is_empty(coro_batch_idx, true)) {
+          not prev->readers.is_empty(coro_batch_idx, true)) {
         // Read-only optimization: safe if T1 is read-only (so far) and T1's
         // begin ts
         // is before ct3.
         if (config::enable_ssi_read_only_opt) {
-          TXN::readers_bitmap_iterator readers_iter(&prev->readers_bitmap);
+          TXN::readers_iterator readers_iter(&prev->readers);
           while (true) {
-            int32_t xid_idx = readers_iter.next(xc, true);
+            int32_t xid_idx = readers_iter.next(coro_batch_idx, true);
             if (xid_idx == -1) break;
 
             XID rxid = volatile_read(TXN::rlist.xids[xid_idx]);
@@ -1456,7 +1456,7 @@ rc_t transaction::ssn_read(dbtuple *tuple) {
       // already read a (then latest) version, then T2 comes to overwrite it).
       read_set.emplace_back(tuple);
     }
-    serial_register_reader_tx(coro_batch_idx, &tuple->readers_bitmap);
+    serial_register_reader_tx(coro_batch_idx, &tuple->readers);
   }
 
 #ifdef EARLY_SSN_CHECK
@@ -1490,7 +1490,7 @@ rc_t transaction::ssi_read(dbtuple *tuple) {
     if (not xc->ct3 or xc->ct3 > tuple_s1.offset()) xc->ct3 = tuple_s1.offset();
     // The purpose of adding a version to read-set is to re-check its
     // sstamp status at precommit and set its xstamp for updaters' (if
-    // exist) reference during pre-commit thru the readers bitmap.
+    // exist) reference during pre-commit thru the reader slots.
     // The xstamp is only useful for versions that haven't been updated,
     // or whose updates haven't been finalized. It's only used by the
     // updater at precommit. Once updated (ie v.sstamp is ASI_LOG), future
@@ -1500,7 +1500,7 @@ rc_t transaction::ssi_read(dbtuple *tuple) {
   } else {
     // survived, register as a reader
     // After this point, I'll be visible to the updater (if any)
-    serial_register_reader_tx(coro_batch_idx, &tuple->readers_bitmap);
+    serial_register_reader_tx(coro_batch_idx, &tuple->readers);
     read_set.emplace_back(tuple);
   }
   return {RC_TRUE};
@@ -251,6 +251,9 @@ class fast_random {
 
   inline void set_seed(unsigned long seed) { this->seed = seed; }
 
+  // Start over as if constructed with [seed]
+  inline void reseed(unsigned long seed) { set_seed0(seed); }
+
  private:
   inline void set_seed0(unsigned long seed) {
     this->seed = (seed ^ 0x5DEECE66DL) & ((1L << 48) - 1);
@@ -298,6 +301,8 @@ class timer {
  public:
   timer() { lap(); }
   timer(const timer &t) : start(t.start) {};
+  // Started at [start_us] instead of now, e.g., an intended start time
+  explicit timer(uint64_t start_us) : start(start_us) {}
 
   inline uint64_t lap() {
     uint64_t t0 = start;